@@ -0,0 +1,140 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include <stdexcept>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// 马的8个走法
+static const int dx[] = { 1,  2, 2, 1, -1, -2, -2, -1};
+static const int dy[] = {-2, -1, 1, 2,  2,  1, -1, -2};
+
+// 128位的位棋盘，第sq位对应格子sq = y * 宽 + x，9x10的棋盘只用到低90位。
+// 走子、数出路、判断是否走过都变成与、或和popcount。
+struct Bitboard
+{
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+
+    Bitboard() = default;
+    Bitboard(uint64_t l, uint64_t h):lo(l), hi(h) {}
+
+    static Bitboard Square(int sq)
+    {
+        return sq < 64 ? Bitboard(uint64_t(1) << sq, 0) : Bitboard(0, uint64_t(1) << (sq - 64));
+    }
+
+    bool Test(int sq) const
+    {
+        return sq < 64 ? (lo >> sq) & 1 : (hi >> (sq - 64)) & 1;
+    }
+    void Set(int sq) { *this |= Square(sq); }
+    void Reset(int sq) { *this &= ~Square(sq); }
+
+    bool Empty() const { return (lo | hi) == 0; }
+    int Count() const { return PopCount(lo) + PopCount(hi); }
+
+    // 最低的一位，Empty()时结果无意义
+    int Lowest() const { return lo ? Ctz(lo) : 64 + Ctz(hi); }
+    int PopLowest()
+    {
+        int sq = Lowest();
+        if(lo)
+            lo &= lo - 1;
+        else
+            hi &= hi - 1;
+        return sq;
+    }
+
+    Bitboard operator&(const Bitboard& o) const { return Bitboard(lo & o.lo, hi & o.hi); }
+    Bitboard operator|(const Bitboard& o) const { return Bitboard(lo | o.lo, hi | o.hi); }
+    Bitboard operator^(const Bitboard& o) const { return Bitboard(lo ^ o.lo, hi ^ o.hi); }
+    Bitboard operator~() const { return Bitboard(~lo, ~hi); }
+    Bitboard& operator&=(const Bitboard& o) { lo &= o.lo; hi &= o.hi; return *this; }
+    Bitboard& operator|=(const Bitboard& o) { lo |= o.lo; hi |= o.hi; return *this; }
+    bool operator==(const Bitboard& o) const { return lo == o.lo && hi == o.hi; }
+    bool operator!=(const Bitboard& o) const { return !(*this == o); }
+
+    static int PopCount(uint64_t v)
+    {
+#ifdef _MSC_VER
+        return int(__popcnt64(v));
+#else
+        return __builtin_popcountll(v);
+#endif
+    }
+    static int Ctz(uint64_t v)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, v);
+        return int(index);
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+};
+
+// 预先算好的马步表：每个格子能跳到的格子集合，以及每个方向跳到哪个格子
+class KnightMoves
+{
+public:
+    static const int MAX_SQUARES = 128;
+
+    KnightMoves(int width, int height):width_(width), height_(height)
+    {
+        // 表是定长数组，先检查再填：超过128格的棋盘在越界写之前就抛异常，NDEBUG下也一样
+        if(!Fits(width, height))
+        {
+            throw std::invalid_argument("board must have 1 to 128 squares");
+        }
+        for(int y = 0; y < height; ++y)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                int sq = y * width + x;
+                all_.Set(sq);
+                for(int i = 0; i < 8; ++i)
+                {
+                    int nx = x + dx[i];
+                    int ny = y + dy[i];
+                    if(nx >= 0 && nx < width && ny >= 0 && ny < height)
+                    {
+                        jump_[sq][i] = ny * width + nx;
+                        attacks_[sq].Set(ny * width + nx);
+                    }
+                    else
+                    {
+                        jump_[sq][i] = -1;
+                    }
+                }
+            }
+        }
+    }
+
+    // width x height的棋盘能不能放进这些表。用除法比较，很大的宽高相乘也不会溢出
+    static bool Fits(int width, int height)
+    {
+        return width > 0 && height > 0 && width <= MAX_SQUARES / height;
+    }
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    int Size() const { return width_ * height_; }
+
+    // 棋盘上的所有格子
+    const Bitboard& All() const { return all_; }
+    const Bitboard& Attacks(int sq) const { return attacks_[sq]; }
+    // 从sq往第dir个方向跳到的格子，出界时为-1
+    int Jump(int sq, int dir) const { return jump_[sq][dir]; }
+private:
+    int width_;
+    int height_;
+    Bitboard all_;
+    Bitboard attacks_[MAX_SQUARES];
+    int jump_[MAX_SQUARES][8];
+};
+
+#endif // BITBOARD_H
@@ -22,16 +22,23 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
-CONFIG += c++11
+CONFIG += c++11 thread
+
+# 位棋盘大量用到popcount，x86上打开popcnt指令
+!msvc:contains(QT_ARCH, x86_64): QMAKE_CXXFLAGS += -mpopcnt
 
 SOURCES += \
         main.cpp \
         chessboard.cpp \
-    chessgrid.cpp
+    chessgrid.cpp \
+    tour_worker.cpp
 
 HEADERS += \
         chessboard.h \
-    chessgrid.h
+    chessgrid.h \
+    bitboard.h \
+    rng.h \
+    tour_worker.h
 
 FORMS += \
         chessboard.ui
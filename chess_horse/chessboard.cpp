@@ -5,97 +5,93 @@
 #include <QDebug>
 #include <QThread>
 
-ChessBoard::ChessBoard(QWidget *parent) :
+ChessBoard::ChessBoard(int width, int height, bool closed, uint64_t seed, QWidget *parent) :
     QGraphicsView(parent),
-    ui(new Ui::ChessBoard)
+    ui(new Ui::ChessBoard),
+    width_(width),
+    height_(height),
+    grid_size_(std::max(20, GRID_SIZE * HEIGHT / std::max(width, height)))
 {
     ui->setupUi(this);
     timer_ = new QTimer(this);
     scene_.setParent(this);
-    this->resize(9*GRID_SIZE + 20, 10 * GRID_SIZE + 20);
+    this->resize(width_ * grid_size_ + 20, height_ * grid_size_ + 20);
     this->setScene(&scene_);
     connect(timer_, SIGNAL(timeout()), this, SLOT(timeout()));
     CalcPoints();
-    for(QGraphicsLineItem& l: grid_meridian_)
-    {
-        scene_.addItem(&l);
-    }
-    for(QGraphicsLineItem& l: grid_latitude_)
-    {
-        scene_.addItem(&l);
-    }
-    grid_ = new ChessGrid(3, 5);
-    timer_->start(30);
+    CreateGridLines();
+    worker_ = new TourWorker(std::min(3, width_ - 1), std::min(5, height_ - 1), width_, height_, closed, seed);
+    setWindowTitle(QString("chess_horse %1x%2 seed %3").arg(width_).arg(height_).arg(worker_->Seed()));
+    timer_->start(16); // 大约60帧每秒
 }
 
 ChessBoard::~ChessBoard()
 {
+    delete worker_;
     delete ui;
 }
 
 void ChessBoard::CalcPoints()
 {
-    for(int y = 0; y < 10; ++y)
+    points_.resize(width_ * height_);
+    for(int y = 0; y < height_; ++y)
     {
-        for(int x = 0; x < 9; ++x)
+        for(int x = 0; x < width_; ++x)
         {
-            int xvalue = 10 + x * GRID_SIZE;
-            int yvalue = 10 + y * GRID_SIZE;
-            points_[y][x] = QPoint{xvalue, yvalue};
+            int xvalue = 10 + x * grid_size_;
+            int yvalue = 10 + y * grid_size_;
+            points_[y * width_ + x] = QPoint{xvalue, yvalue};
         }
     }
+}
 
-    for(int y = 0; y < 10; ++y)
-    {
-        grid_meridian_[y].setLine(points_[y][0].x(), points_[y][0].y(), points_[y][8].x(), points_[y][8].y());
-    }
-
-    for(int x = 0; x < 7; ++x)
+// 横线每行一条；竖线每列一条，9x10的象棋棋盘中间是楚河汉界，除了两边的竖线都在第4、5行之间断开
+void ChessBoard::CreateGridLines()
+{
+    auto add_line = [this](int x1, int y1, int x2, int y2) {
+        const QPoint& p1 = points_[y1 * width_ + x1];
+        const QPoint& p2 = points_[y2 * width_ + x2];
+        grid_lines_.push_back(scene_.addLine(p1.x(), p1.y(), p2.x(), p2.y()));
+    };
+    bool river = width_ == WIDTH && height_ == HEIGHT;
+    for(int y = 0; y < height_; ++y)
     {
-        grid_latitude_[x].setLine(points_[0][x+1].x(), points_[0][x+1].y(),
-                points_[4][x+1].x(), points_[4][x+1].y());
+        add_line(0, y, width_ - 1, y);
     }
-
-    for(int x = 7; x < 14; ++x)
+    for(int x = 0; x < width_; ++x)
     {
-        grid_latitude_[x].setLine(points_[5][x+1-7].x(), points_[5][x+1-7].y(),
-                points_[9][x+1-7].x(), points_[9][x+1-7].y());
+        if(river && x > 0 && x < width_ - 1)
+        {
+            add_line(x, 0, x, 4);
+            add_line(x, 5, x, height_ - 1);
+        }
+        else
+        {
+            add_line(x, 0, x, height_ - 1);
+        }
     }
-    grid_latitude_[14].setLine(points_[0][0].x(), points_[0][0].y(), points_[9][0].x(), points_[9][0].y());
-    grid_latitude_[15].setLine(points_[0][8].x(), points_[0][8].y(), points_[9][8].x(), points_[9][8].y());
-}
-
-void ChessBoard::CreateGridLines()
-{
-
 }
 
 
+// 界面定时器只负责画：取后台线程最新发布的路径，复用已有的线段，只增删长度变化的部分
 void ChessBoard::timeout()
 {
-    if(grid_->Finished())
+    if(!worker_->Latest(snapshot_))
     {
-        timer_->stop();
         return;
     }
-    grid_->Step();
 
-    vector<std::pair<int, int>>& points = grid_->points;
-    for(auto it: pathes_)
+    const vector<std::pair<int, int>>& points = snapshot_.points;
+    size_t lines = points.empty() ? 0 : points.size() - 1;
+    while(pathes_.size() > lines)
     {
-        QGraphicsLineItem* l = it;
-        scene_.removeItem(l);
-        delete l;
+        scene_.removeItem(pathes_.back());
+        delete pathes_.back();
+        pathes_.pop_back();
     }
-    pathes_.clear();
-
-    for(int i = 1; i < int(points.size()); ++i)
+    while(pathes_.size() < lines)
     {
-        int x1 = points_[points[i-1].second][points[i-1].first].x();
-        int y1 = points_[points[i-1].second][points[i-1].first].y();
-        int x2 = points_[points[i].second][points[i].first].x();
-        int y2 = points_[points[i].second][points[i].first].y();
-        QGraphicsLineItem* l = new QGraphicsLineItem(x1, y1, x2, y2);
+        QGraphicsLineItem* l = new QGraphicsLineItem;
         QPen pen;
         pen.setColor(Qt::red);
         pen.setWidth(3);
@@ -103,6 +99,19 @@ void ChessBoard::timeout()
         scene_.addItem(l);
         pathes_.push_back(l);
     }
-    update();
-    //qDebug()<<"timer griggered...";
+
+    for(int i = 1; i < int(points.size()); ++i)
+    {
+        const QPoint& p1 = points_[points[i-1].second * width_ + points[i-1].first];
+        const QPoint& p2 = points_[points[i].second * width_ + points[i].first];
+        pathes_[i - 1]->setLine(p1.x(), p1.y(), p2.x(), p2.y());
+    }
+
+    setWindowTitle(QString("chess_horse %1x%2 seed %3, %4 steps%5")
+                   .arg(width_).arg(height_).arg(worker_->Seed()).arg(snapshot_.steps)
+                   .arg(snapshot_.finished ? (snapshot_.found ? ", found" : ", no tour") : ""));
+    if(snapshot_.finished)
+    {
+        timer_->stop();
+    }
 }
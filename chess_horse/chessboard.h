@@ -9,6 +9,7 @@
 #include <QPoint>
 #include <QGraphicsItemGroup>
 #include "chessgrid.h"
+#include "tour_worker.h"
 
 namespace Ui {
 class ChessBoard;
@@ -19,9 +20,11 @@ class ChessBoard : public QGraphicsView
     Q_OBJECT
     static const int WIDTH = 9;
     static const int HEIGHT = 10;
-    static const int GRID_SIZE = 100; // 每个格子的边长
+    static const int GRID_SIZE = 100; // 9x10时每个格子的边长，大棋盘按比例缩小
 public:
-    explicit ChessBoard(QWidget *parent = nullptr);
+    // 默认是9x10的象棋棋盘；closed为true时找闭合路径；seed为0时随机取种子，窗口标题上显示实际用的种子
+    explicit ChessBoard(int width = WIDTH, int height = HEIGHT, bool closed = false, uint64_t seed = 0,
+                        QWidget *parent = nullptr);
     ~ChessBoard() override;
 private:
     void CalcPoints();
@@ -32,10 +35,13 @@ private:
     Ui::ChessBoard *ui;
     QGraphicsScene scene_;
     QTimer* timer_;
-    QPoint points_[HEIGHT][WIDTH];
-    QGraphicsLineItem grid_meridian_[10];
-    QGraphicsLineItem grid_latitude_[16];
-    ChessGrid* grid_;
+    int width_;
+    int height_;
+    int grid_size_;
+    vector<QPoint> points_; // 第y行第x列的交叉点是points_[y * width_ + x]
+    vector<QGraphicsLineItem*> grid_lines_;
+    TourWorker* worker_; // 在后台线程上搜索，timeout()按刷新率取最新的路径来画
+    TourSnapshot snapshot_;
     vector<QGraphicsLineItem*> pathes_;
 };
 
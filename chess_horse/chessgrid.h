@@ -8,12 +8,11 @@
 #include <algorithm>
 #include <iomanip>
 #include <random>
+#include "bitboard.h"
+#include "rng.h"
 
 using namespace std;
 
-static const int dx[] = { 1,  2, 2, 1, -1, -2, -2, -1};
-static const int dy[] = {-2, -1, 1, 2,  2,  1, -1, -2};
-
 struct StackItem
 {
     StackItem(int xx, int yy, int l):x(xx), y(yy), level(l)
@@ -37,15 +36,24 @@ class ChessGrid
 {
     friend class ChessBoard;
 public:
-    explicit ChessGrid(int x, int y)
+    // 默认是9x10的象棋棋盘，格子数不能超过128（位棋盘的大小，KnightMoves构造时检查）；closed为true时要求最后一步能跳回起点。
+    // seed为0时随机取一个种子。同一个棋盘、起点和种子，每一步的选择都完全一样，
+    // 把Seed()报出来的种子传回来就能重放一次很慢的搜索
+    explicit ChessGrid(int x, int y, int w = 9, int h = 10, bool closed = false, uint64_t seed = 0)
+        :width(w), height(h), closed(closed), moves(w, h), grid(w * h, 0),
+         seed(seed ? seed : RandomSeed()), rng(this->seed), steps(0)
     {
         x0 = x;
         y0 = y;
         level = 1;
         current_x = x;
         current_y = y;
-        memset(grid, 0, sizeof(grid));
-        grid[y0][x0] = level;
+        grid[y0 * width + x0] = level;
+        occupied.Set(y0 * width + x0);
+        for(int i = 0; i < 8; ++i)
+        {
+            order[i] = i;
+        }
         path.push(StackItem(x, y, 1));
         points.push_back(std::make_pair(x0, y0));
     }
@@ -55,16 +63,19 @@ public:
         if(path.empty())
             return true;
 
-        if(path.top().level >= 90)
+        const StackItem& top = path.top();
+        if(top.level >= width * height
+            && (!closed || moves.Attacks(y0 * width + x0).Test(top.y * width + top.x)))
         {
-            for(int y = 0; y < 10; ++y)
+            for(int y = 0; y < height; ++y)
             {
-                for(int x = 0; x < 9; ++x)
+                for(int x = 0; x < width; ++x)
                 {
-                    cout<<std::setw(2)<<grid[y][x]<<" ";
+                    cout<<std::setw(3)<<grid[y * width + x]<<" ";
                 }
                 cout<<"\n";
             }
+            cout<<"seed: "<<seed<<", steps: "<<steps<<"\n";
             return true;
         }
 
@@ -78,12 +89,14 @@ public:
             cout<<"empty path!!!!\n";
             return;
         }
+        ++steps;
         StackItem& si = path.top();
         //cout<<si.x<<", "<<si.y<<", level="<<si.level<<", index="<<si.Count()<<"\n";
         int next_index = NextIndex(si);
         if(next_index < 0)
         {
-            grid[si.y][si.x] = 0;
+            grid[si.y * width + si.x] = 0;
+            occupied.Reset(si.y * width + si.x);
             path.pop();
             points.pop_back();
             return;
@@ -91,29 +104,46 @@ public:
         si.visited[next_index] = true;
         StackItem new_item(si.x + dx[next_index], si.y + dy[next_index], si.level+1);
         path.push(new_item);
-        grid[new_item.y][new_item.x] = new_item.level;
+        grid[new_item.y * width + new_item.x] = new_item.level;
+        occupied.Set(new_item.y * width + new_item.x);
         points.push_back(std::make_pair(new_item.x, new_item.y));
     }
+
+    uint64_t Seed() const { return seed; }
+    // 当前路径上的每个格子，从起点开始
+    const vector<std::pair<int, int>>& Points() const { return points; }
+    long long Steps() const { return steps; }
 private:
+    static uint64_t RandomSeed()
+    {
+        std::random_device rd;
+        uint64_t s = (uint64_t(rd()) << 32) | rd();
+        return s ? s : 1;
+    }
+
     int NextIndex(StackItem& si)
     {
         int ret = -1;
         //int max_way = 100;
-        static int arr[] = {0, 1, 2, 3, 4, 5, 6, 7};
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(begin(arr), end(arr), g);
+        // Fisher-Yates洗牌，8!远小于2^64，一个随机数拆成每一步的下标就够了。
+        // 不用std::shuffle是因为它的实现各个标准库不一样，同一个种子换个编译器就重放不出来
+        uint64_t r = rng();
+        for(int i = 7; i > 0; --i)
+        {
+            std::swap(order[i], order[r % (i + 1)]);
+            r /= i + 1;
+        }
 
+        int sq = si.y * width + si.x;
         for(int index = 0; index < 8; ++index)
         {
-            int i = arr[index];
-            int x = si.x + dx[i];
-            int y = si.y + dy[i];
-            if(x >= 0 && x < 9 && y >= 0 && y < 10 && !grid[y][x] && !si.visited[i])
+            int i = order[index];
+            int to = moves.Jump(sq, i);
+            if(to >= 0 && !occupied.Test(to) && !si.visited[i])
             {
                 return i;
                 /*
-                int wo = WayOut(x, y);
+                int wo = WayOut(to % width, to / width);
                 if(wo < max_way)
                 {
                     max_way = wo;
@@ -124,29 +154,29 @@ private:
 
         return ret;
     }
+    // (xvalue, yvalue)还没走过的邻居数
     int WayOut(int xvalue, int yvalue)
     {
-        int ret = 0;
-        for(int i = 0; i < 8; ++i)
-        {
-            int x = xvalue + dx[i];
-            int y = yvalue + dy[i];
-            if(x >= 0 && x < 9 && y >= 0 && y < 10 && !grid[y][x])
-            {
-                ++ret;
-            }
-        }
-        return ret;
+        return (moves.Attacks(yvalue * width + xvalue) & ~occupied).Count();
     }
 private:
+    int width;
+    int height;
+    bool closed;
+    KnightMoves moves;
     int x0;
     int y0;
     int level;
     int current_x;
     int current_y;
-    int grid[10][9];
+    vector<int> grid; // 每个格子是第几步走到的，0表示没走过
+    Bitboard occupied; // 已经走过的格子
     stack<StackItem> path;
     vector<std::pair<int, int>> points;
+    uint64_t seed;
+    Xoshiro256 rng;
+    int order[8]; // 每一步尝试8个方向的顺序
+    long long steps; // Step()调用的次数
 };
 
 #endif // CHESSGRID_H
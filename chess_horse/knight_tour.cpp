@@ -0,0 +1,214 @@
+#include "knight_tour.h"
+#include <algorithm>
+
+KnightTour::KnightTour(int width, int height):moves_(width, height)
+{
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            int cx = 2 * x - (width - 1);
+            int cy = 2 * y - (height - 1);
+            center_dist_[y * width + x] = cx * cx + cy * cy;
+        }
+    }
+}
+
+// 列出sq的所有可走格子，并按Warnsdorff规则排序；随机化搜索时出路一样多的按随机顺序
+void KnightTour::MakeFrame(int sq, Frame& frame)
+{
+    int key1[8];
+    int key2[8];
+    frame.count = 0;
+    frame.next = 0;
+    bool last = int(path_.size()) + 1 == Size(); // 下一步是最后一步
+    const Bitboard& home = moves_.Attacks(start_);
+    Bitboard cands = moves_.Attacks(sq) & free_;
+    while(!cands.Empty())
+    {
+        int c = cands.PopLowest();
+        Bitboard next = moves_.Attacks(c) & free_;
+        int degree = next.Count();
+        if(last)
+        {
+            // 闭合路径的最后一格必须能跳回起点
+            if(closed_ && !home.Test(c))
+            {
+                continue;
+            }
+        }
+        else
+        {
+            // 走过去就没路了
+            if(degree == 0)
+            {
+                continue;
+            }
+            // 闭合路径要给最后一步留一个能回到起点的格子
+            Bitboard back = home & free_;
+            back.Reset(c);
+            if(closed_ && back.Empty())
+            {
+                continue;
+            }
+        }
+        int sum = 0;
+        if(randomized_)
+        {
+            sum = int(rng_() >> 33);
+        }
+        else
+        {
+            while(!next.Empty())
+            {
+                sum += Degree(next.PopLowest());
+            }
+        }
+        // 插入排序：出路少的在前，其次邻居出路之和小的在前，再其次离中心远的在前
+        int k = frame.count++;
+        while(k > 0)
+        {
+            int p = frame.cand[k-1];
+            bool less = degree != key1[k-1] ? degree < key1[k-1]
+                : sum != key2[k-1] ? sum < key2[k-1]
+                : center_dist_[c] > center_dist_[p];
+            if(!less)
+            {
+                break;
+            }
+            frame.cand[k] = p;
+            key1[k] = key1[k-1];
+            key2[k] = key2[k-1];
+            --k;
+        }
+        frame.cand[k] = c;
+        key1[k] = degree;
+        key2[k] = sum;
+    }
+}
+
+long long KnightTour::Luby(long long i)
+{
+    for(;;)
+    {
+        long long k = 1;
+        while((1LL << k) - 1 < i)
+        {
+            ++k;
+        }
+        if((1LL << k) - 1 == i)
+        {
+            return 1LL << (k - 1);
+        }
+        i -= (1LL << (k - 1)) - 1;
+    }
+}
+
+// Schwenk定理：m <= n的棋盘有闭合路径，除非m和n都是奇数，或者m是1、2、4，或者m是3且n是4、6、8
+bool KnightTour::ClosedTourExists(int width, int height)
+{
+    int m = std::min(width, height);
+    int n = std::max(width, height);
+    if((m % 2 == 1 && n % 2 == 1) || m == 1 || m == 2 || m == 4)
+    {
+        return false;
+    }
+    return !(m == 3 && (n == 4 || n == 6 || n == 8));
+}
+
+bool KnightTour::Solve(int x, int y, vector<std::pair<int, int>>& tour)
+{
+    // 马每步都换颜色，格子数是奇数时只能从多的那种颜色（和角上同色）出发
+    bool wrong_color = Size() % 2 == 1 && (x + y) % 2 == 1;
+    if(wrong_color || (closed_ && !ClosedTourExists(Width(), Height())))
+    {
+        nodes_ = 0;
+        backtracks_ = 0;
+        return false;
+    }
+    // 先按确定的Warnsdorff顺序走；回溯太多说明掉进了一棵很难走出来的子树，
+    // 换成随机顺序重新开始，回溯上限按Luby序列增长。
+    // 重启次数用完还没找到，就不限回溯次数完整地搜一遍，没有解时也能给出确定的答案。
+    long long nodes = 0;
+    long long backtracks = 0;
+    bool ok = false;
+    cancel_ = nullptr;
+    for(int k = 0; !ok && k <= MAX_RESTARTS; ++k)
+    {
+        randomized_ = k > 0;
+        rng_.Seed(uint64_t(k));
+        max_backtracks_ = k < MAX_RESTARTS ? RESTART_CUTOFF * Luby(k + 1) : 0;
+        if(k == MAX_RESTARTS)
+        {
+            randomized_ = false;
+        }
+        ok = Search(x, y, tour);
+        nodes += nodes_;
+        backtracks += backtracks_;
+    }
+    nodes_ = nodes;
+    backtracks_ = backtracks;
+    return ok;
+}
+
+bool KnightTour::SolveRandomized(int x, int y, uint64_t seed, long long max_backtracks,
+                                 const std::atomic<bool>* cancel, vector<std::pair<int, int>>& tour)
+{
+    rng_.Seed(seed);
+    randomized_ = true;
+    max_backtracks_ = max_backtracks;
+    cancel_ = cancel;
+    return Search(x, y, tour);
+}
+
+bool KnightTour::Search(int x, int y, vector<std::pair<int, int>>& tour)
+{
+    free_ = moves_.All();
+    nodes_ = 0;
+    backtracks_ = 0;
+    path_.clear();
+    stack_.clear();
+
+    start_ = y * Width() + x;
+    free_.Reset(start_);
+    path_.push_back(start_);
+    stack_.emplace_back();
+    MakeFrame(start_, stack_.back());
+    while(!stack_.empty())
+    {
+        if(int(path_.size()) == Size())
+        {
+            tour.clear();
+            for(int sq: path_)
+            {
+                tour.push_back(std::make_pair(sq % Width(), sq / Width()));
+            }
+            return true;
+        }
+        Frame& frame = stack_.back();
+        if(frame.next == frame.count)
+        {
+            // 死路，退回上一步
+            stack_.pop_back();
+            free_.Set(path_.back());
+            path_.pop_back();
+            ++backtracks_;
+            if(max_backtracks_ > 0 && backtracks_ > max_backtracks_)
+            {
+                return false;
+            }
+            continue;
+        }
+        if(cancel_ && (nodes_ & 1023) == 0 && cancel_->load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        int sq = frame.cand[frame.next++];
+        free_.Reset(sq);
+        path_.push_back(sq);
+        ++nodes_;
+        stack_.emplace_back();
+        MakeFrame(sq, stack_.back());
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+#ifndef KNIGHT_TOUR_H
+#define KNIGHT_TOUR_H
+
+#include <vector>
+#include <utility>
+#include <atomic>
+#include <cstdint>
+#include "bitboard.h"
+#include "rng.h"
+
+using namespace std;
+
+// 不依赖Qt的马踏棋盘求解器。
+// 按Warnsdorff规则走：优先走出路最少的格子；出路一样多时比较这些格子的邻居出路之和（Pohl规则），
+// 再一样时优先离棋盘中心远的格子。只有走进死路时才回溯，绝大多数起点一次都不用回溯；
+// 偶尔回溯太多时换随机顺序重启。
+// 棋盘用位棋盘表示，出路数就是 popcount(马步表 & 没走过的格子)，所以格子数不能超过128，
+// 更大的棋盘用large_tour.h里的分治构造。
+class KnightTour
+{
+public:
+    static const int WIDTH = 9;   // 默认是象棋棋盘
+    static const int HEIGHT = 10;
+
+    explicit KnightTour(int width = WIDTH, int height = HEIGHT);
+
+    int Width() const { return moves_.Width(); }
+    int Height() const { return moves_.Height(); }
+    int Size() const { return moves_.Size(); }
+
+    // 要求闭合路径：最后一步能跳回起点
+    void SetClosed(bool closed) { closed_ = closed; }
+    bool Closed() const { return closed_; }
+
+    // 从(x, y)出发找一条走遍所有格子的路径，tour里按顺序存放每一步的(x, y)
+    bool Solve(int x, int y, vector<std::pair<int, int>>& tour);
+
+    // Luby序列的第i项（i从1开始）：1, 1, 2, 1, 1, 2, 4, ...，用作重启时的回溯上限倍数
+    static long long Luby(long long i);
+    static bool ClosedTourExists(int width, int height);
+
+    // 随机化的版本：出路一样多的候选按seed决定的随机顺序走。
+    // 回溯超过max_backtracks次（0表示不限）或者cancel被置位时放弃，返回false。
+    bool SolveRandomized(int x, int y, uint64_t seed, long long max_backtracks,
+                         const std::atomic<bool>* cancel, vector<std::pair<int, int>>& tour);
+
+    // 最近一次求解走过的步数和回溯次数
+    long long Nodes() const { return nodes_; }
+    long long Backtracks() const { return backtracks_; }
+private:
+    static const long long RESTART_CUTOFF = 1000;
+    static const int MAX_RESTARTS = 64;
+
+    struct Frame
+    {
+        int count;
+        int next;
+        int cand[8];
+    };
+
+    // 格子sq还没走过的邻居数
+    int Degree(int sq) const { return (moves_.Attacks(sq) & free_).Count(); }
+    void MakeFrame(int sq, Frame& frame);
+    bool Search(int x, int y, vector<std::pair<int, int>>& tour);
+private:
+    KnightMoves moves_;
+    int center_dist_[KnightMoves::MAX_SQUARES]; // 到棋盘中心距离的平方（乘以4取整）
+    bool closed_ = false;
+    int start_ = 0;
+    Bitboard free_;         // 还没走过的格子
+    vector<int> path_;
+    vector<Frame> stack_;
+    long long nodes_ = 0;
+    long long backtracks_ = 0;
+    // 随机化搜索的状态
+    Xoshiro256 rng_;
+    bool randomized_ = false;
+    long long max_backtracks_ = 0;
+    const std::atomic<bool>* cancel_ = nullptr;
+};
+
+#endif // KNIGHT_TOUR_H
@@ -0,0 +1,241 @@
+#include "large_tour.h"
+#include "knight_tour.h"
+#include <map>
+
+namespace {
+
+// 闭合路径表示成每个格子在圈上的两个邻居，删边加边都是O(1)
+class Cycle
+{
+public:
+    Cycle(int width, int height):width_(width), height_(height), nb_(size_t(width) * height * 2, -1) {}
+
+    int Neighbor(int sq, int k) const { return nb_[size_t(sq) * 2 + k]; }
+
+    void Link(int a, int b)
+    {
+        nb_[size_t(a) * 2 + (nb_[size_t(a) * 2] < 0 ? 0 : 1)] = b;
+        nb_[size_t(b) * 2 + (nb_[size_t(b) * 2] < 0 ? 0 : 1)] = a;
+    }
+
+    // 把边a-b换成a-c
+    void Relink(int a, int b, int c)
+    {
+        int& slot = nb_[size_t(a) * 2] == b ? nb_[size_t(a) * 2] : nb_[size_t(a) * 2 + 1];
+        slot = c;
+    }
+
+    // 删掉a-b和p-q，连上a-p和b-q
+    void Swap(int a, int b, int p, int q)
+    {
+        Relink(a, b, p);
+        Relink(b, a, q);
+        Relink(p, q, a);
+        Relink(q, p, b);
+    }
+
+    void Walk(int start, vector<int>& order) const
+    {
+        order.clear();
+        order.reserve(size_t(width_) * height_);
+        int prev = -1;
+        int cur = start;
+        do
+        {
+            order.push_back(cur);
+            int next = Neighbor(cur, 0) != prev ? Neighbor(cur, 0) : Neighbor(cur, 1);
+            prev = cur;
+            cur = next;
+        } while(cur != start && int(order.size()) <= width_ * height_);
+    }
+private:
+    int width_;
+    int height_;
+    vector<int> nb_;
+};
+
+struct Rect
+{
+    int x0;
+    int y0;
+    int x1; // 不含
+    int y1; // 不含
+
+    bool Contains(int x, int y) const { return x >= x0 && x < x1 && y >= y0 && y < y1; }
+};
+
+// 把一条边切成6到11的段，偶数边全是偶数段，奇数边只有最后一段是奇数
+vector<int> SplitSide(int d)
+{
+    vector<int> parts;
+    while(d >= 12)
+    {
+        parts.push_back(6);
+        d -= 6;
+    }
+    parts.push_back(d);
+    return parts;
+}
+
+// 小块的闭合路径，同样大小的块只求一次
+const vector<int>* BaseTour(int w, int h)
+{
+    static std::map<std::pair<int, int>, vector<int>> cache;
+    auto it = cache.find(std::make_pair(w, h));
+    if(it != cache.end())
+    {
+        return &it->second;
+    }
+    KnightTour solver(w, h);
+    solver.SetClosed(true);
+    vector<std::pair<int, int>> tour;
+    for(uint64_t seed = 1; seed <= 10000; ++seed)
+    {
+        if(solver.SolveRandomized(0, 0, seed, 1000, nullptr, tour))
+        {
+            vector<int>& order = cache[std::make_pair(w, h)];
+            for(const auto& p: tour)
+            {
+                order.push_back(p.second * w + p.first);
+            }
+            return &order;
+        }
+    }
+    return nullptr;
+}
+
+// 在两个相邻区域的接缝处找两条可以交换的边，把两个圈拼成一个。
+// seam里是第一个区域靠近接缝的格子，只有这些格子才可能跳进区域b。
+bool Join(Cycle& cycle, int width, const Rect& b, const vector<int>& seam)
+{
+    for(int u: seam)
+    {
+        int ux = u % width;
+        int uy = u / width;
+        for(int k = 0; k < 2; ++k)
+        {
+            int v = cycle.Neighbor(u, k);
+            int vx = v % width;
+            int vy = v / width;
+            for(int i = 0; i < 8; ++i)
+            {
+                int px = ux + dx[i];
+                int py = uy + dy[i];
+                if(!b.Contains(px, py))
+                {
+                    continue;
+                }
+                int p = py * width + px;
+                for(int j = 0; j < 2; ++j)
+                {
+                    int q = cycle.Neighbor(p, j);
+                    int ddx = q % width - vx;
+                    int ddy = q / width - vy;
+                    if(ddx * ddx + ddy * ddy == 5)
+                    {
+                        cycle.Swap(u, v, p, q);
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool LargeTourSupported(int width, int height)
+{
+    return width >= 6 && height >= 6 && (width % 2 == 0 || height % 2 == 0);
+}
+
+bool BuildClosedTour(int width, int height, vector<int>& tour)
+{
+    if(!LargeTourSupported(width, height))
+    {
+        return false;
+    }
+    vector<int> cols = SplitSide(width);
+    vector<int> rows = SplitSide(height);
+    Cycle cycle(width, height);
+
+    // 每一块铺上同样大小的小闭合路径
+    for(int r = 0, y0 = 0; r < int(rows.size()); y0 += rows[r], ++r)
+    {
+        for(int c = 0, x0 = 0; c < int(cols.size()); x0 += cols[c], ++c)
+        {
+            const vector<int>* base = BaseTour(cols[c], rows[r]);
+            if(!base)
+            {
+                return false;
+            }
+            for(size_t i = 0; i < base->size(); ++i)
+            {
+                int a = (*base)[i];
+                int b = (*base)[(i + 1) % base->size()];
+                cycle.Link((y0 + a / cols[c]) * width + x0 + a % cols[c],
+                           (y0 + b / cols[c]) * width + x0 + b % cols[c]);
+            }
+        }
+    }
+
+    vector<int> seam;
+    // 每一行从左到右拼
+    for(int r = 0, y0 = 0; r < int(rows.size()); y0 += rows[r], ++r)
+    {
+        int y1 = y0 + rows[r];
+        for(int c = 1, x0 = cols[0]; c < int(cols.size()); x0 += cols[c], ++c)
+        {
+            seam.clear();
+            for(int y = y0; y < y1; ++y)
+            {
+                seam.push_back(y * width + x0 - 1);
+                seam.push_back(y * width + x0 - 2);
+            }
+            if(!Join(cycle, width, Rect{x0, y0, x0 + cols[c], y1}, seam))
+            {
+                return false;
+            }
+        }
+    }
+    // 各行从上到下拼
+    for(int r = 1, y0 = rows[0]; r < int(rows.size()); y0 += rows[r], ++r)
+    {
+        seam.clear();
+        for(int x = 0; x < width; ++x)
+        {
+            seam.push_back((y0 - 1) * width + x);
+            seam.push_back((y0 - 2) * width + x);
+        }
+        if(!Join(cycle, width, Rect{0, y0, width, y0 + rows[r]}, seam))
+        {
+            return false;
+        }
+    }
+
+    cycle.Walk(0, tour);
+    return int(tour.size()) == width * height;
+}
+
+bool BuildLargeTour(int width, int height, int x, int y, vector<std::pair<int, int>>& tour)
+{
+    vector<int> order;
+    if(x < 0 || x >= width || y < 0 || y >= height || !BuildClosedTour(width, height, order))
+    {
+        return false;
+    }
+    size_t start = 0;
+    while(order[start] != y * width + x)
+    {
+        ++start;
+    }
+    tour.clear();
+    tour.reserve(order.size());
+    for(size_t i = 0; i < order.size(); ++i)
+    {
+        int sq = order[(start + i) % order.size()];
+        tour.push_back(std::make_pair(sq % width, sq / width));
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#ifndef LARGE_TOUR_H
+#define LARGE_TOUR_H
+
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+// 大棋盘（比如1000x1000）的马踏棋盘，分治构造，时间和格子数成正比。
+// 把棋盘切成边长6到11的小块，每块用KnightTour找一条闭合路径（同样大小的块共用一条）；
+// 再沿着块之间的接缝把相邻的两个圈拼成一个：在接缝两边各找一条圈上的边(u, v)和(p, q)，
+// 使u-p、v-q都是马步，删掉两条旧边、连上两条新边，两个圈就成了一个圈。
+// 先把每一行的块从左到右拼起来，再把各行从上到下拼起来，每次拼接只看接缝附近的格子。
+// 长宽都是奇数时格子数是奇数，不存在闭合路径；任何一边小于6的棋盘这里也不支持，返回false。
+
+// 这里能不能构造width x height的路径：两边都不小于6，且至少一边是偶数。
+// 开放路径也是从闭合路径得到的，所以不满足时同样不支持
+bool LargeTourSupported(int width, int height);
+
+// 构造一条闭合路径，tour里按顺序存放格子编号（y * width + x），从格子0开始
+bool BuildClosedTour(int width, int height, vector<int>& tour);
+
+// 从(x, y)出发沿闭合路径走一圈，得到的路径最后一步总能跳回起点
+bool BuildLargeTour(int width, int height, int x, int y, vector<std::pair<int, int>>& tour);
+
+#endif // LARGE_TOUR_H
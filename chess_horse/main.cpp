@@ -1,10 +1,44 @@
 #include "chessboard.h"
 #include <QApplication>
+#include <QStringList>
 
+// chess_horse [宽 高] [closed] [seed 种子]
+// 默认是9x10的象棋棋盘，格子数不能超过128。窗口标题上显示本次搜索的种子，用seed传回来可以重放同一次搜索
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
-    ChessBoard w;
+    QStringList args = a.arguments();
+    int width = 9;
+    int height = 10;
+    bool closed = false;
+    uint64_t seed = 0;
+    vector<int> size;
+    for(int i = 1; i < args.size(); ++i)
+    {
+        if(args[i] == "closed")
+        {
+            closed = true;
+        }
+        else if(args[i] == "seed" && i + 1 < args.size())
+        {
+            seed = args[++i].toULongLong();
+        }
+        else
+        {
+            size.push_back(args[i].toInt());
+        }
+    }
+    if(size.size() >= 2)
+    {
+        width = size[0];
+        height = size[1];
+    }
+    if(!KnightMoves::Fits(width, height))
+    {
+        cerr<<"board must have 1 to "<<KnightMoves::MAX_SQUARES<<" squares\n";
+        return 2;
+    }
+    ChessBoard w(width, height, closed, seed);
     w.show();
 
     return a.exec();
@@ -0,0 +1,60 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// xoshiro256**：状态只有32字节，生成一个数只要几条移位和乘法，
+// 不像std::mt19937那样有5KB的状态要初始化，也不用每次都去读std::random_device。
+// 满足UniformRandomBitGenerator，可以直接传给std::shuffle。同一个种子总是得到同一个序列。
+class Xoshiro256
+{
+public:
+    typedef uint64_t result_type;
+
+    explicit Xoshiro256(uint64_t seed = 0)
+    {
+        Seed(seed);
+    }
+
+    // 用SplitMix64把一个64位种子展开成256位状态
+    void Seed(uint64_t seed)
+    {
+        for(uint64_t& v: s_)
+        {
+            v = SplitMix64(seed);
+        }
+    }
+
+    static uint64_t SplitMix64(uint64_t& x)
+    {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()()
+    {
+        uint64_t result = Rotl(s_[1] * 5, 7) * 9;
+        uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = Rotl(s_[3], 45);
+        return result;
+    }
+private:
+    static uint64_t Rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t s_[4];
+};
+
+#endif // RNG_H
@@ -0,0 +1,319 @@
+#include "knight_tour.h"
+#include "tour_search.h"
+#include "large_tour.h"
+#include "chessgrid.h"
+#include "tour_count.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+
+struct Board
+{
+    int width = KnightTour::WIDTH;
+    int height = KnightTour::HEIGHT;
+    bool closed = false;
+};
+
+static double MicrosecondsSince(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// 检查路径每一步都是马步、每个格子恰好走一次，closed时最后一步还要能跳回起点
+static bool CheckTour(const Board& board, const vector<std::pair<int, int>>& tour)
+{
+    if(tour.size() != size_t(board.width) * board.height)
+    {
+        return false;
+    }
+    vector<char> seen(tour.size(), 0);
+    for(size_t i = 0; i < tour.size(); ++i)
+    {
+        if(seen[size_t(tour[i].second) * board.width + tour[i].first]++)
+        {
+            return false;
+        }
+        if(i + 1 == tour.size() && !board.closed)
+        {
+            break;
+        }
+        const auto& next = tour[(i + 1) % tour.size()];
+        int ddx = next.first - tour[i].first;
+        int ddy = next.second - tour[i].second;
+        if(ddx * ddx + ddy * ddy != 5)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 多线程随机重启搜索跑runs次，每次换一个有解的起点和种子，统计找到解的耗时分布。
+// 每次最多尝试max_attempts次，没找到的算失败，不计入耗时分布（4x4这样根本没有路径的棋盘全部失败）
+static int Race(const Board& board, int runs, unsigned threads, long long cutoff, long long max_attempts)
+{
+    if(runs <= 0 || max_attempts <= 0)
+    {
+        cerr<<"runs and max attempts must be positive\n";
+        return 2;
+    }
+    if(board.closed && !KnightTour::ClosedTourExists(board.width, board.height))
+    {
+        cout<<board.width<<"x"<<board.height<<" has no closed tour\n";
+        return 1;
+    }
+    Xoshiro256 rng(std::chrono::steady_clock::now().time_since_epoch().count());
+    vector<double> times;
+    vector<long long> attempts;
+    int failed = 0;
+    uint64_t slowest_seed = 0;
+    int slowest_x = 0;
+    int slowest_y = 0;
+    for(int r = 0; r < runs; ++r)
+    {
+        int x = int(rng() % board.width);
+        int y = int(rng() % board.height);
+        // 格子数是奇数时只从多的那种颜色出发，另一种颜色出发没有解
+        while(board.width * board.height % 2 == 1 && (x + y) % 2 == 1)
+        {
+            x = int(rng() % board.width);
+            y = int(rng() % board.height);
+        }
+        TourSearchResult res = ParallelTourSearch(board.width, board.height, board.closed, x, y,
+                                                  threads, rng(), cutoff, max_attempts);
+        if(!res.found)
+        {
+            ++failed;
+            continue;
+        }
+        if(times.empty() || res.seconds * 1e6 > *std::max_element(times.begin(), times.end()))
+        {
+            slowest_seed = res.seed;
+            slowest_x = x;
+            slowest_y = y;
+        }
+        times.push_back(res.seconds * 1e6);
+        attempts.push_back(res.attempts);
+    }
+    cout<<runs<<" runs, "<<threads<<" threads, cutoff "<<cutoff<<", "<<failed<<" failed after "
+        <<max_attempts<<" attempts\n";
+    if(times.empty())
+    {
+        cout<<"no run found a tour\n";
+        return 1;
+    }
+    std::sort(times.begin(), times.end());
+    std::sort(attempts.begin(), attempts.end());
+    auto pct = [](const vector<double>& v, double p) { return v[std::min(v.size() - 1, size_t(p * v.size()))]; };
+    cout<<"time-to-solution us: min "<<times.front()<<", p50 "<<pct(times, 0.5)<<", p90 "<<pct(times, 0.9)
+        <<", p99 "<<pct(times, 0.99)<<", max "<<times.back()<<"\n";
+    cout<<"attempts: p50 "<<attempts[attempts.size() / 2]<<", max "<<attempts.back()<<"\n";
+    cout<<"slowest run: start ("<<slowest_x<<", "<<slowest_y<<"), winning seed "<<slowest_seed<<"\n";
+    return 0;
+}
+
+// 从每个格子出发各求一次，统计耗时和回溯次数
+static int SolveAll(const Board& board)
+{
+    KnightTour solver(board.width, board.height);
+    solver.SetClosed(board.closed);
+    vector<std::pair<int, int>> tour;
+    double total_us = 0;
+    double max_us = 0;
+    long long backtracks = 0;
+    int failed = 0;
+    for(int y = 0; y < board.height; ++y)
+    {
+        for(int x = 0; x < board.width; ++x)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            bool ok = solver.Solve(x, y, tour);
+            double us = MicrosecondsSince(t0);
+            total_us += us;
+            max_us = std::max(max_us, us);
+            backtracks += solver.Backtracks();
+            if(!ok || !CheckTour(board, tour))
+            {
+                ++failed;
+            }
+        }
+    }
+    cout<<"squares: "<<solver.Size()<<", failed: "<<failed
+        <<", avg: "<<total_us / solver.Size()<<" us, max: "<<max_us<<" us"
+        <<", backtracks: "<<backtracks<<"\n";
+    return failed == 0 ? 0 : 1;
+}
+
+// 从(x, y)出发求一条路径。不超过128格的棋盘用KnightTour搜索，更大的用分治构造
+static int SolveOne(const Board& board, int x, int y)
+{
+    vector<std::pair<int, int>> tour;
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok;
+    if(KnightMoves::Fits(board.width, board.height))
+    {
+        KnightTour solver(board.width, board.height);
+        solver.SetClosed(board.closed);
+        ok = solver.Solve(x, y, tour);
+    }
+    else
+    {
+        ok = BuildLargeTour(board.width, board.height, x, y, tour);
+    }
+    double us = MicrosecondsSince(t0);
+    if(!ok)
+    {
+        cout<<"no tour from ("<<x<<", "<<y<<")\n";
+        return 1;
+    }
+
+    if(board.width <= 30 && board.height <= 30)
+    {
+        vector<int> grid(size_t(board.width) * board.height);
+        for(int i = 0; i < int(tour.size()); ++i)
+        {
+            grid[tour[i].second * board.width + tour[i].first] = i + 1;
+        }
+        int w = int(std::to_string(tour.size()).size());
+        for(int yy = 0; yy < board.height; ++yy)
+        {
+            for(int xx = 0; xx < board.width; ++xx)
+            {
+                cout<<std::setw(w)<<grid[yy * board.width + xx]<<" ";
+            }
+            cout<<"\n";
+        }
+    }
+    cout<<board.width<<"x"<<board.height<<(board.closed ? " closed" : "")<<" tour "
+        <<(CheckTour(board, tour) ? "ok" : "INVALID")<<", "<<us<<" us\n";
+    return 0;
+}
+
+// 用界面上的随机深度优先搜索（ChessGrid）求一条路径，最多走max_steps步。
+// 报出种子、步数和每步耗时，界面上很慢的一次搜索可以拿种子在这里重放和profile
+static int RunGrid(const Board& board, uint64_t seed, long long max_steps)
+{
+    ChessGrid grid(std::min(3, board.width - 1), std::min(5, board.height - 1),
+                   board.width, board.height, board.closed, seed);
+    auto t0 = std::chrono::steady_clock::now();
+    bool finished = false;
+    while(grid.Steps() < max_steps && !(finished = grid.Finished()))
+    {
+        grid.Step();
+    }
+    double us = MicrosecondsSince(t0);
+    cout<<(finished ? "finished" : "gave up")<<", seed: "<<grid.Seed()<<", steps: "<<grid.Steps()
+        <<", "<<us * 1000 / std::max(1LL, grid.Steps())<<" ns/step\n";
+    return finished ? 0 : 1;
+}
+
+// 穷举从(x, y)出发的所有路径，报出条数和每个核每秒走的步数
+static int Count(const Board& board, int x, int y, unsigned threads, int split_depth)
+{
+    TourCountResult res = CountTours(board.width, board.height, board.closed, x, y, threads, split_depth);
+    cout<<board.width<<"x"<<board.height<<(board.closed ? " closed" : "")<<" tours from ("<<x<<", "<<y<<"): "
+        <<res.count<<"\n";
+    cout<<res.nodes<<" nodes in "<<res.seconds<<" s, "<<res.nodes / res.seconds / res.threads / 1e6
+        <<" M nodes/s per core, "<<res.threads<<" threads\n";
+    cout<<res.tasks<<" tasks at depth "<<split_depth<<", "<<res.steals<<" stolen, nodes per thread:";
+    for(long long n: res.thread_nodes)
+    {
+        cout<<" "<<n;
+    }
+    cout<<"\n";
+    return 0;
+}
+
+// 命令行版本的马踏棋盘，不需要Qt。
+// tour_cli [-w 宽] [-h 高] [-c] 命令
+//   -w/-h 棋盘大小，默认9x10；-c 要求闭合路径
+//   x y  从(x, y)出发求一条路径并打印每个格子是第几步，超过128格的棋盘用分治构造（总是闭合的）
+//   all  从每个格子出发各求一次，统计耗时和回溯次数
+//   race [次数] [线程数] [回溯上限] [尝试次数]  多线程随机重启搜索，统计找到解的耗时分布
+//   count x y [线程数] [切分深度]  穷举从(x, y)出发的所有路径，适合5x5、6x6这样的小棋盘
+//   grid [种子] [最多步数]  跑界面上的随机深度优先搜索，种子为0时随机取，可以用报出的种子重放
+int main(int argc, char *argv[])
+{
+    Board board;
+    int arg = 1;
+    for(; arg < argc && argv[arg][0] == '-'; ++arg)
+    {
+        if(strcmp(argv[arg], "-c") == 0)
+        {
+            board.closed = true;
+        }
+        else if(arg + 1 < argc && strcmp(argv[arg], "-w") == 0)
+        {
+            board.width = atoi(argv[++arg]);
+        }
+        else if(arg + 1 < argc && strcmp(argv[arg], "-h") == 0)
+        {
+            board.height = atoi(argv[++arg]);
+        }
+    }
+    if(board.width <= 0 || board.height <= 0)
+    {
+        cerr<<"bad board size\n";
+        return 2;
+    }
+    bool small = KnightMoves::Fits(board.width, board.height);
+
+    if(arg < argc && (strcmp(argv[arg], "race") == 0 || strcmp(argv[arg], "all") == 0
+                     || strcmp(argv[arg], "grid") == 0 || strcmp(argv[arg], "count") == 0) && !small)
+    {
+        cerr<<"search needs a board of at most "<<KnightMoves::MAX_SQUARES<<" squares\n";
+        return 2;
+    }
+    if(arg + 2 < argc && strcmp(argv[arg], "count") == 0)
+    {
+        int x = atoi(argv[arg + 1]);
+        int y = atoi(argv[arg + 2]);
+        if(x < 0 || x >= board.width || y < 0 || y >= board.height)
+        {
+            cerr<<"start square out of board\n";
+            return 2;
+        }
+        unsigned threads = arg + 3 < argc ? unsigned(atoi(argv[arg + 3])) : std::thread::hardware_concurrency();
+        int split_depth = arg + 4 < argc ? atoi(argv[arg + 4]) : 8;
+        return Count(board, x, y, threads, split_depth);
+    }
+    if(arg < argc && strcmp(argv[arg], "grid") == 0)
+    {
+        uint64_t seed = arg + 1 < argc ? strtoull(argv[arg + 1], nullptr, 10) : 0;
+        long long max_steps = arg + 2 < argc ? atoll(argv[arg + 2]) : 100000000;
+        return RunGrid(board, seed, max_steps);
+    }
+    if(arg < argc && strcmp(argv[arg], "race") == 0)
+    {
+        int runs = arg + 1 < argc ? atoi(argv[arg + 1]) : 1000;
+        unsigned threads = arg + 2 < argc ? unsigned(atoi(argv[arg + 2])) : std::thread::hardware_concurrency();
+        long long cutoff = arg + 3 < argc ? atoll(argv[arg + 3]) : 100;
+        long long max_attempts = arg + 4 < argc ? atoll(argv[arg + 4]) : 10000;
+        return Race(board, runs, threads, cutoff, max_attempts);
+    }
+    if(arg < argc && strcmp(argv[arg], "all") == 0)
+    {
+        return SolveAll(board);
+    }
+
+    int x = arg + 1 < argc ? atoi(argv[arg]) : std::min(3, board.width - 1);
+    int y = arg + 1 < argc ? atoi(argv[arg + 1]) : std::min(5, board.height - 1);
+    if(x < 0 || x >= board.width || y < 0 || y >= board.height)
+    {
+        cerr<<"start square out of board\n";
+        return 2;
+    }
+    // 超过128格的棋盘只能分治构造，构造不了的尺寸先拒绝，别等算完再报no tour
+    if(!small && !LargeTourSupported(board.width, board.height))
+    {
+        cerr<<board.width<<"x"<<board.height<<": boards over "<<KnightMoves::MAX_SQUARES
+            <<" squares need both sides at least 6 and one side even"
+            <<(board.closed ? "\n" : "; open tours for large odd boards are unsupported\n");
+        return 2;
+    }
+    return SolveOne(board, x, y);
+}
@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# 不依赖Qt界面的马踏棋盘求解器，命令行程序
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = tour_cli
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+# 位棋盘大量用到popcount，x86上打开popcnt指令
+!msvc:contains(QT_ARCH, x86_64): QMAKE_CXXFLAGS += -mpopcnt
+
+SOURCES += \
+        tour_cli.cpp \
+        knight_tour.cpp \
+        tour_search.cpp \
+        large_tour.cpp \
+        tour_count.cpp
+
+HEADERS += \
+        knight_tour.h \
+        tour_search.h \
+        large_tour.h \
+        tour_count.h \
+        chessgrid.h \
+        bitboard.h \
+        rng.h
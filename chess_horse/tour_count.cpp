@@ -0,0 +1,218 @@
+#include "tour_count.h"
+#include "bitboard.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// 一棵待搜索的子树：马在sq上，free是还没走过的格子
+struct Task
+{
+    int sq;
+    Bitboard free;
+};
+
+class Counter
+{
+public:
+    Counter(const KnightMoves& moves, int start, bool closed)
+        :moves_(moves), start_(start), closed_(closed)
+    {
+    }
+
+    // 从sq出发走完free里所有格子的路径数
+    uint64_t Count(int sq, const Bitboard& free)
+    {
+        ++nodes_;
+        if(free.Empty())
+        {
+            return !closed_ || moves_.Attacks(sq).Test(start_) ? 1 : 0;
+        }
+        if(Prune(sq, free))
+        {
+            return 0;
+        }
+        uint64_t count = 0;
+        Bitboard next = moves_.Attacks(sq) & free;
+        while(!next.Empty())
+        {
+            int to = next.PopLowest();
+            Bitboard rest = free;
+            rest.Reset(to);
+            count += Count(to, rest);
+        }
+        return count;
+    }
+
+    // 从sq出发走depth步，把没被剪掉的子树放进tasks；不到depth步就走完了的路径直接计数
+    uint64_t Split(int sq, const Bitboard& free, int depth, vector<Task>& tasks)
+    {
+        if(depth == 0 || free.Empty())
+        {
+            if(free.Empty())
+            {
+                return Count(sq, free);
+            }
+            tasks.push_back(Task{sq, free});
+            return 0;
+        }
+        ++nodes_;
+        if(Prune(sq, free))
+        {
+            return 0;
+        }
+        uint64_t count = 0;
+        Bitboard next = moves_.Attacks(sq) & free;
+        while(!next.Empty())
+        {
+            int to = next.PopLowest();
+            Bitboard rest = free;
+            rest.Reset(to);
+            count += Split(to, rest, depth - 1, tasks);
+        }
+        return count;
+    }
+
+    long long Nodes() const { return nodes_; }
+private:
+    // 剩下的格子已经不可能走完时返回true
+    bool Prune(int sq, const Bitboard& free) const
+    {
+        Bitboard graph = free | Bitboard::Square(sq);
+        if(closed_)
+        {
+            graph.Set(start_);
+        }
+        int ends = 0;
+        Bitboard rest = free;
+        while(!rest.Empty())
+        {
+            int degree = (moves_.Attacks(rest.PopLowest()) & graph).Count();
+            if(degree < (closed_ ? 2 : 1) || (degree == 1 && ++ends > 1))
+            {
+                return true;
+            }
+        }
+
+        Bitboard reach = moves_.Attacks(sq) & free;
+        Bitboard frontier = reach;
+        while(!frontier.Empty())
+        {
+            Bitboard more = moves_.Attacks(frontier.PopLowest()) & free & ~reach;
+            reach |= more;
+            frontier |= more;
+        }
+        return reach != free;
+    }
+
+    const KnightMoves& moves_;
+    int start_;
+    bool closed_;
+    long long nodes_ = 0;
+};
+
+// 每个线程一个双端队列。自己从尾部取，别人从头部偷，两头很少碰到一起，一把锁就够了
+struct alignas(64) TaskQueue
+{
+    std::mutex mutex;
+    std::deque<Task> tasks;
+};
+
+} // namespace
+
+TourCountResult CountTours(int width, int height, bool closed, int x, int y,
+                           unsigned threads, int split_depth)
+{
+    if(threads == 0)
+    {
+        threads = 1;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    KnightMoves moves(width, height);
+    int start = y * width + x;
+    Bitboard free = moves.All();
+    free.Reset(start);
+
+    TourCountResult result;
+    result.threads = threads;
+    vector<Task> tasks;
+    Counter splitter(moves, start, closed);
+    uint64_t shallow = splitter.Split(start, free, split_depth, tasks);
+    result.tasks = (long long)tasks.size();
+
+    vector<TaskQueue> queues(threads);
+    for(size_t i = 0; i < tasks.size(); ++i)
+    {
+        queues[i % threads].tasks.push_back(tasks[i]);
+    }
+
+    std::atomic<uint64_t> count(shallow);
+    std::atomic<long long> steals(0);
+    result.thread_nodes.assign(threads, 0);
+    auto worker = [&](unsigned id)
+    {
+        Counter counter(moves, start, closed);
+        uint64_t my_count = 0;
+        long long my_steals = 0;
+        for(;;)
+        {
+            Task task;
+            bool got = false;
+            {
+                TaskQueue& own = queues[id];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if(!own.tasks.empty())
+                {
+                    task = own.tasks.back();
+                    own.tasks.pop_back();
+                    got = true;
+                }
+            }
+            // 任务都是一开始就切好的，不会再有新任务进来，所有队列都空了就可以退出
+            for(unsigned k = 1; !got && k < threads; ++k)
+            {
+                TaskQueue& victim = queues[(id + k) % threads];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if(!victim.tasks.empty())
+                {
+                    task = victim.tasks.front();
+                    victim.tasks.pop_front();
+                    got = true;
+                    ++my_steals;
+                }
+            }
+            if(!got)
+            {
+                break;
+            }
+            my_count += counter.Count(task.sq, task.free);
+        }
+        count += my_count;
+        steals += my_steals;
+        result.thread_nodes[id] = counter.Nodes();
+    };
+
+    vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; ++t)
+    {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for(std::thread& th: pool)
+    {
+        th.join();
+    }
+
+    result.count = count;
+    result.steals = steals;
+    result.nodes = splitter.Nodes();
+    for(long long n: result.thread_nodes)
+    {
+        result.nodes += n;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return result;
+}
@@ -0,0 +1,31 @@
+#ifndef TOUR_COUNT_H
+#define TOUR_COUNT_H
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+struct TourCountResult
+{
+    uint64_t count = 0;     // 路径条数。闭合路径按方向算，每个回路会被数两次
+    long long nodes = 0;    // 所有线程一共走了多少步
+    long long tasks = 0;    // 在split_depth处切出来的子树个数
+    long long steals = 0;   // 从别的线程队列里偷来的任务数
+    unsigned threads = 0;
+    double seconds = 0;
+    vector<long long> thread_nodes; // 每个线程走的步数，看负载是否均衡
+};
+
+// 穷举width x height的棋盘上从(x, y)出发的所有马踏棋盘路径，closed为true时只数能跳回起点的。
+// 先单线程走split_depth步，把搜索树切成一棵棵子树作为任务，轮流放进每个线程自己的双端队列；
+// 线程从自己队列的尾部取任务，自己的做完了就从别的线程队列的头部偷，树不平衡时也不会有线程闲着。
+// 每一步都做两种剪枝：
+//   度数：没走过的格子（连同当前格子，闭合时还有起点）里，除了终点每个格子至少要有两个邻居，
+//         只有一个邻居的格子只能是终点，所以最多一个；闭合时终点是起点，每个格子都要有两个邻居
+//   连通：没走过的格子必须都能从当前格子走到
+// 和ChessGrid一样用位棋盘，格子数不能超过128。
+TourCountResult CountTours(int width, int height, bool closed, int x, int y,
+                           unsigned threads, int split_depth);
+
+#endif // TOUR_COUNT_H
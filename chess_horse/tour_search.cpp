@@ -0,0 +1,76 @@
+#include "tour_search.h"
+#include "knight_tour.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+TourSearchResult ParallelTourSearch(int width, int height, bool closed, int x, int y,
+                                    unsigned threads, uint64_t seed, long long cutoff,
+                                    long long max_attempts)
+{
+    if(threads == 0)
+    {
+        threads = 1;
+    }
+    TourSearchResult result;
+    // 和KnightTour::Solve一样：格子数是奇数时从少的那种颜色出发不可能走完，
+    // 要求闭合路径时还要棋盘有闭合路径（Schwenk定理），否则不用开始搜
+    if((width * height % 2 == 1 && (x + y) % 2 == 1) || (closed && !KnightTour::ClosedTourExists(width, height)))
+    {
+        return result;
+    }
+    std::atomic<bool> cancel(false);
+    std::atomic<long long> next_attempt(0);
+    std::atomic<long long> nodes(0);
+    std::mutex mutex;
+    auto t0 = std::chrono::steady_clock::now();
+
+    auto worker = [&]()
+    {
+        KnightTour solver(width, height);
+        solver.SetClosed(closed);
+        vector<std::pair<int, int>> tour;
+        long long my_nodes = 0;
+        while(!cancel.load(std::memory_order_relaxed))
+        {
+            long long k = next_attempt.fetch_add(1, std::memory_order_relaxed);
+            if(max_attempts > 0 && k >= max_attempts)
+            {
+                break;
+            }
+            uint64_t s = seed + uint64_t(k);
+            uint64_t attempt_seed = Xoshiro256::SplitMix64(s);
+            bool ok = solver.SolveRandomized(x, y, attempt_seed, cutoff * KnightTour::Luby(k + 1), &cancel, tour);
+            my_nodes += solver.Nodes();
+            if(ok && !cancel.exchange(true))
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                result.found = true;
+                result.tour = tour;
+                result.seed = attempt_seed;
+            }
+        }
+        nodes += my_nodes;
+    };
+
+    vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; ++t)
+    {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for(std::thread& th: pool)
+    {
+        th.join();
+    }
+
+    result.attempts = next_attempt.load();
+    if(max_attempts > 0 && result.attempts > max_attempts)
+    {
+        result.attempts = max_attempts;
+    }
+    result.nodes = nodes.load();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return result;
+}
@@ -0,0 +1,30 @@
+#ifndef TOUR_SEARCH_H
+#define TOUR_SEARCH_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+using namespace std;
+
+struct TourSearchResult
+{
+    bool found = false;
+    vector<std::pair<int, int>> tour;
+    uint64_t seed = 0;      // 找到解的那次尝试的种子，传给KnightTour::SolveRandomized可以重现
+    long long attempts = 0; // 所有线程一共尝试了多少次
+    long long nodes = 0;    // 所有线程一共走了多少步
+    double seconds = 0;
+};
+
+// 多线程随机重启搜索。
+// threads个线程各自领取尝试编号，第k次尝试的种子由seed和k决定，回溯上限是cutoff乘以Luby序列的第k项
+// （1, 1, 2, 1, 1, 2, 4, ...），运气不好的尝试很快就放弃换个种子重来，不会卡死在一棵子树里。
+// 任何一个线程找到完整路径就通知其他线程停止；max_attempts次都没找到也停止（0表示不限）。
+// width x height的棋盘，closed为true时要求闭合路径。
+// 起点颜色不对或者棋盘没有闭合路径时一定无解，直接返回found为false。
+TourSearchResult ParallelTourSearch(int width, int height, bool closed, int x, int y,
+                                    unsigned threads, uint64_t seed, long long cutoff,
+                                    long long max_attempts = 0);
+
+#endif // TOUR_SEARCH_H
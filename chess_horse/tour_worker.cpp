@@ -0,0 +1,75 @@
+#include "tour_worker.h"
+#include "chessgrid.h"
+
+TourWorker::TourWorker(int x, int y, int width, int height, bool closed, uint64_t seed,
+                       std::chrono::milliseconds publish_interval)
+    :seed_(0), publish_interval_(publish_interval), stop_(false), version_(0), taken_(0)
+{
+    // seed为0时由ChessGrid随机取，先在这里取好，界面一启动就能显示出来
+    seed_ = ChessGrid(x, y, width, height, closed, seed).Seed();
+    thread_ = std::thread(&TourWorker::Run, this, x, y, width, height, closed);
+}
+
+TourWorker::~TourWorker()
+{
+    Stop();
+}
+
+void TourWorker::Stop()
+{
+    stop_ = true;
+    if(thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+bool TourWorker::Latest(TourSnapshot& snapshot)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(version_ == taken_)
+    {
+        return false;
+    }
+    snapshot = latest_;
+    taken_ = version_;
+    return true;
+}
+
+void TourWorker::Run(int x, int y, int width, int height, bool closed)
+{
+    // 每走BATCH步才看一次时钟，看时钟比走一步还贵
+    const int BATCH = 1024;
+    ChessGrid grid(x, y, width, height, closed, seed_);
+    auto publish = [&](bool finished)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        latest_.points = grid.Points();
+        latest_.steps = grid.Steps();
+        latest_.finished = finished;
+        latest_.found = finished && !grid.Points().empty();
+        latest_.seed = seed_;
+        ++version_;
+    };
+
+    auto next_publish = std::chrono::steady_clock::now();
+    bool finished = false;
+    while(!stop_.load(std::memory_order_relaxed) && !finished)
+    {
+        for(int i = 0; i < BATCH; ++i)
+        {
+            if(grid.Finished())
+            {
+                finished = true;
+                break;
+            }
+            grid.Step();
+        }
+        auto now = std::chrono::steady_clock::now();
+        if(finished || now >= next_publish)
+        {
+            publish(finished);
+            next_publish = now + publish_interval_;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef TOUR_WORKER_H
+#define TOUR_WORKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// 后台线程上某一时刻的搜索进度
+struct TourSnapshot
+{
+    vector<std::pair<int, int>> points; // 当前路径
+    long long steps = 0;                // 到这时一共走了多少步
+    bool finished = false;              // 搜索已结束（找到了路径，或者所有分支都试过了）
+    bool found = false;
+    uint64_t seed = 0;
+};
+
+// 在后台线程上全速跑ChessGrid的随机深度优先搜索。
+// 搜索线程每隔publish_interval把当前路径拷一份发布出来，界面按自己的刷新率用Latest()取最新的一份去画，
+// 中间的步骤直接跳过。搜索速度不再受界面定时器的限制，界面线程也不会被搜索卡住。
+// 参数和ChessGrid一样。析构时会停止并等待后台线程。
+class TourWorker
+{
+public:
+    TourWorker(int x, int y, int width, int height, bool closed, uint64_t seed,
+               std::chrono::milliseconds publish_interval = std::chrono::milliseconds(15));
+    ~TourWorker();
+    TourWorker(const TourWorker&) = delete;
+    TourWorker& operator=(const TourWorker&) = delete;
+
+    // 有比上次取走的更新的快照时拷到snapshot里并返回true
+    bool Latest(TourSnapshot& snapshot);
+    // 让后台线程尽快停下来并等它结束
+    void Stop();
+    uint64_t Seed() const { return seed_; }
+private:
+    void Run(int x, int y, int width, int height, bool closed);
+
+    uint64_t seed_;
+    std::chrono::milliseconds publish_interval_;
+    std::atomic<bool> stop_;
+    std::mutex mutex_;
+    TourSnapshot latest_;    // 受mutex_保护
+    long long version_;      // 每发布一次加一，受mutex_保护
+    long long taken_;        // 界面取走的版本，只在界面线程用
+    std::thread thread_;
+};
+
+#endif // TOUR_WORKER_H
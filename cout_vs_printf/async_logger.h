@@ -0,0 +1,322 @@
+#pragma once
+// AsyncLogger: logging that keeps formatting and I/O off the calling thread.
+//   - each thread that logs gets its own single-producer single-consumer ring buffer
+//   - a call to ASYNC_LOG copies a binary record into that ring: a format id and the raw
+//     arguments (numbers by value, strings as length + bytes); no formatting, no locks, no syscalls
+//   - one background thread drains all rings, formats the records with FastSink and writes them in
+//     batches: one write(2) per pass over the rings, or when FastSink's buffer fills up
+//   - when a ring is full the caller waits for the background thread (Overflow::Block) or the
+//     record is dropped and counted (Overflow::Drop)
+//
+//   AsyncLogger log(STDOUT_FILENO);
+//   ASYNC_LOG(log, "id={} name={} value={:.3f}", id, name, value);
+//
+// The format string is checked at compile time like FastSink::println. Records from one thread
+// come out in order; records from different threads are interleaved by pass, not by time.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "fast_sink.h"
+
+namespace async_log {
+
+// Strings are copied into the record and come back as string_views into the ring.
+template <class T>
+constexpr bool is_string_v = std::is_convertible_v<const T&, std::string_view> && !std::is_arithmetic_v<T>;
+
+template <class T>
+using Stored = std::conditional_t<is_string_v<T>, std::string_view, T>;
+
+template <class T>
+size_t encoded_size(const T& value) {
+    if constexpr(is_string_v<T>) {
+        return sizeof(uint32_t) + std::string_view(value).size();
+    } else {
+        static_assert(std::is_arithmetic_v<T>, "log arguments must be numbers or strings");
+        return sizeof(T);
+    }
+}
+
+template <class T>
+char* encode(char* p, const T& value) {
+    if constexpr(is_string_v<T>) {
+        std::string_view s(value);
+        uint32_t n = uint32_t(s.size());
+        std::memcpy(p, &n, sizeof(n));
+        std::memcpy(p + sizeof(n), s.data(), n);
+        return p + sizeof(n) + n;
+    } else {
+        std::memcpy(p, &value, sizeof(T));
+        return p + sizeof(T);
+    }
+}
+
+template <class T>
+T decode(const char*& p) {
+    if constexpr(std::is_same_v<T, std::string_view>) {
+        uint32_t n;
+        std::memcpy(&n, p, sizeof(n));
+        std::string_view s(p + sizeof(n), n);
+        p += sizeof(n) + n;
+        return s;
+    } else {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+}
+
+// Format ids index a table of decoders, one per (call site, argument types); an id is assigned the
+// first time its call site logs.
+using DecodeFn = void (*)(const char* args, FastSink& out);
+constexpr uint32_t MAX_FORMATS = 4096;
+
+inline DecodeFn formats[MAX_FORMATS];
+inline std::atomic<uint32_t> format_count{0};
+
+inline uint32_t register_format(DecodeFn fn) {
+    uint32_t id = format_count.fetch_add(1);
+    if(id >= MAX_FORMATS) {
+        std::abort();
+    }
+    formats[id] = fn;
+    return id;
+}
+
+template <class F, class... S>
+void decode_record([[maybe_unused]] const char* p, FastSink& out) {
+    std::tuple<S...> args{decode<S>(p)...}; // braced init: decoded left to right
+    std::apply([&](const S&... a) { F{}(out, a...); }, args);
+}
+
+template <class F, class... S>
+uint32_t format_id() {
+    static const uint32_t id = register_format(&decode_record<F, S...>);
+    return id;
+}
+
+struct RecordHeader {
+    uint32_t size; // including the header, a multiple of 8
+    uint32_t id;
+};
+constexpr uint32_t PADDING_ID = ~0u; // fills the end of the ring when a record does not fit there
+
+// A byte ring with one producer and one consumer. Each side caches the other side's position and
+// only reloads it (one cache line transfer) when the cached value says there is no room or no data.
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity): capacity_(capacity), buf_(new char[capacity]) {}
+
+    size_t capacity() const { return capacity_; }
+
+    // Producer: room for n bytes (a multiple of 8, at most capacity / 2) at a contiguous address,
+    // or nullptr if the ring is full. Pads to the end of the ring if the record would wrap.
+    char* reserve(size_t n) {
+        size_t pos = size_t(write_pos_ & (capacity_ - 1));
+        size_t pad = pos + n > capacity_ ? capacity_ - pos : 0;
+        if(write_pos_ + pad + n - cached_read_ > capacity_) {
+            cached_read_ = read_.load(std::memory_order_acquire);
+            if(write_pos_ + pad + n - cached_read_ > capacity_) {
+                return nullptr;
+            }
+        }
+        if(pad) {
+            RecordHeader h{uint32_t(pad), PADDING_ID};
+            std::memcpy(buf_.get() + pos, &h, sizeof(h));
+            write_pos_ += pad;
+            pos = 0;
+        }
+        return buf_.get() + pos;
+    }
+
+    void commit(size_t n) {
+        write_pos_ += n;
+        write_.store(write_pos_, std::memory_order_release);
+    }
+
+    // Consumer: the records published so far, handed to fn(header, args) one by one, then released
+    // in one go. Returns the number of records.
+    template <class Fn>
+    size_t drain(Fn&& fn) {
+        uint64_t end = write_.load(std::memory_order_acquire);
+        size_t records = 0;
+        uint64_t pos = read_pos_;
+        while(pos != end) {
+            const char* p = buf_.get() + (pos & (capacity_ - 1));
+            RecordHeader h;
+            std::memcpy(&h, p, sizeof(h));
+            if(h.id != PADDING_ID) {
+                fn(h, p + sizeof(h));
+                ++records;
+            }
+            pos += h.size;
+        }
+        if(pos != read_pos_) {
+            read_pos_ = pos;
+            read_.store(pos, std::memory_order_release);
+        }
+        return records;
+    }
+
+    bool empty() const { return read_.load(std::memory_order_acquire) == write_.load(std::memory_order_acquire); }
+
+    std::atomic<bool> closed{false}; // the producer thread has exited
+private:
+    const size_t capacity_;
+    std::unique_ptr<char[]> buf_;
+    alignas(64) std::atomic<uint64_t> write_{0};
+    uint64_t write_pos_ = 0;   // producer's copy of write_
+    uint64_t cached_read_ = 0; // producer's last look at read_
+    alignas(64) std::atomic<uint64_t> read_{0};
+    uint64_t read_pos_ = 0;    // consumer's copy of read_
+};
+
+} // namespace async_log
+
+class AsyncLogger {
+public:
+    enum class Overflow { Block, Drop };
+
+    // ring_bytes is per thread and is rounded up to a power of two.
+    explicit AsyncLogger(int fd, size_t ring_bytes = size_t(1) << 20, Overflow overflow = Overflow::Block)
+        : out_(fd), overflow_(overflow) {
+        ring_bytes_ = 4096;
+        while(ring_bytes_ < ring_bytes) {
+            ring_bytes_ *= 2;
+        }
+        worker_ = std::thread([this] { run(); });
+    }
+    // Writes out everything logged before the call.
+    ~AsyncLogger() {
+        stop_.store(true);
+        worker_.join();
+    }
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Use ASYNC_LOG rather than calling this directly: F must be a captureless lambda that formats
+    // the decoded arguments.
+    template <class F, class... Args>
+    void log(F, const Args&... args) {
+        using namespace async_log;
+        static_assert(std::is_empty_v<F> && std::is_default_constructible_v<F>);
+        const uint32_t id = format_id<F, Stored<Args>...>();
+        const size_t size = (sizeof(RecordHeader) + (size_t(0) + ... + encoded_size(args)) + 7) & ~size_t(7);
+        SpscRing& ring = local_ring();
+        if(size > ring.capacity() / 2) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        char* p = ring.reserve(size);
+        while(!p) {
+            if(overflow_ == Overflow::Drop) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            std::this_thread::yield();
+            p = ring.reserve(size);
+        }
+        RecordHeader h{uint32_t(size), id};
+        std::memcpy(p, &h, sizeof(h));
+        [[maybe_unused]] char* q = p + sizeof(h);
+        ((q = encode(q, args)), ...);
+        ring.commit(size);
+    }
+
+    // Waits until everything logged before the call has been written.
+    void flush() {
+        uint64_t start = passes_.load();
+        while(passes_.load() < start + 2) { // the second pass started after this call
+            std::this_thread::yield();
+        }
+    }
+
+    // Records lost to Overflow::Drop or too large for a ring.
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+private:
+    // The calling thread's ring for this logger, created on first use. The thread_local handle
+    // marks the ring closed when the thread exits; the worker drops it once it is drained.
+    async_log::SpscRing& local_ring() {
+        struct Handle {
+            uint64_t logger = 0;
+            std::shared_ptr<async_log::SpscRing> ring;
+            ~Handle() {
+                if(ring) {
+                    ring->closed.store(true);
+                }
+            }
+        };
+        thread_local Handle handle;
+        if(handle.logger != instance_) {
+            if(handle.ring) {
+                handle.ring->closed.store(true);
+            }
+            handle.ring = std::make_shared<async_log::SpscRing>(ring_bytes_);
+            handle.logger = instance_;
+            std::lock_guard<std::mutex> lock(mutex_);
+            rings_.push_back(handle.ring);
+        }
+        return *handle.ring;
+    }
+
+    void run() {
+        using namespace async_log;
+        std::vector<std::shared_ptr<SpscRing>> rings;
+        auto idle = std::chrono::microseconds(20);
+        for(;;) {
+            bool stopping = stop_.load();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                rings = rings_;
+            }
+            size_t records = 0;
+            for(const std::shared_ptr<SpscRing>& ring: rings) {
+                records += ring->drain([&](const RecordHeader& h, const char* args) { formats[h.id](args, out_); });
+            }
+            if(records) {
+                out_.flush();
+                idle = std::chrono::microseconds(20);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::erase_if(rings_, [](const std::shared_ptr<SpscRing>& r) { return r->closed.load() && r->empty(); });
+            }
+            passes_.fetch_add(1);
+            if(stopping) {
+                break;
+            }
+            if(!records) {
+                std::this_thread::sleep_for(idle);
+                idle = std::min(idle * 2, std::chrono::microseconds(1000));
+            }
+        }
+    }
+
+    static inline std::atomic<uint64_t> next_instance_{1};
+
+    const uint64_t instance_ = next_instance_.fetch_add(1);
+    FastSink out_; // used by the worker only
+    Overflow overflow_;
+    size_t ring_bytes_;
+    std::mutex mutex_; // guards rings_
+    std::vector<std::shared_ptr<async_log::SpscRing>> rings_;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> passes_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::thread worker_;
+};
+
+#define ASYNC_LOG(logger, fmt, ...) \
+    (logger).log([](FastSink& out_, const auto&... args_) { out_.println(fmt, args_...); } __VA_OPT__(,) __VA_ARGS__)
@@ -1,10 +1,25 @@
 #include <benchmark/benchmark.h>
 #include <stdio.h>
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <format>
 #include <print>
 #include <fmt/printf.h>
+#include <cinttypes>
+#include <iomanip>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <syncstream>
+#include <thread>
+#include <vector>
+#include "sinks.h"
+#include "fast_sink.h"
+#include "async_logger.h"
 
 void test_printf_string(benchmark::State& state) {
     for(auto _: state) {
@@ -71,4 +86,352 @@ BENCHMARK(test_cout_int);
 BENCHMARK(test_print_int);
 BENCHMARK(test_fmt_pint_int);
 
-BENCHMARK_MAIN();
\ No newline at end of file
+// ---------------------------------------------------------------------------------------------
+// Benchmark matrix: case x method x sink x threads, registered at startup as
+//   <case>/<method>/<sink>/threads:<n>
+// e.g. --benchmark_filter='int64/.*/pipe' or 'mixed/fmt_println/.*'.
+// Every method prints exactly the same bytes for a case (fixed precision floats, no locale), so
+// lines/s and bytes/s are comparable across methods. The per-line values depend on the iteration
+// counter so nothing can be hoisted out of the loop.
+// With more than one thread std::cout goes through std::osyncstream, the standard's way to share
+// it without data races once sync_with_stdio(false) has been called.
+
+// The logger behind the async_log method; its background thread writes to whatever fd 1 is.
+AsyncLogger& async_logger() {
+    static AsyncLogger logger(STDOUT_FILENO);
+    return logger;
+}
+
+struct Doubles {
+    static constexpr const char* name = "doubles";
+    static double a(int64_t i) { return double(i) * 1.000001; }
+    static double b(int64_t i) { return double(i) / 7.0; }
+    static double c(int64_t i) { return 1.0 / double(i + 1); }
+    static void print_f(int64_t i) { printf("%.6f %.6f %.6f\n", a(i), b(i), c(i)); }
+    template <class Os> static void print_os(Os& os, int64_t i) {
+        os<<std::fixed<<std::setprecision(6)<<a(i)<<' '<<b(i)<<' '<<c(i)<<'\n';
+    }
+    static void print_std(int64_t i) { std::println("{:.6f} {:.6f} {:.6f}", a(i), b(i), c(i)); }
+    static void print_fmt(int64_t i) { fmt::println("{:.6f} {:.6f} {:.6f}", a(i), b(i), c(i)); }
+    static void print_fast(FastSink& out, int64_t i) { out.println("{:.6f} {:.6f} {:.6f}", a(i), b(i), c(i)); }
+    static void print_async(AsyncLogger& log, int64_t i) { ASYNC_LOG(log, "{:.6f} {:.6f} {:.6f}", a(i), b(i), c(i)); }
+    template <class Out> static Out format(Out out, int64_t i) {
+        return std::format_to(out, "{:.6f} {:.6f} {:.6f}\n", a(i), b(i), c(i));
+    }
+};
+
+struct Int64 {
+    static constexpr const char* name = "int64";
+    static int64_t a(int64_t i) { return int64_t(uint64_t(i) * 0x9E3779B97F4A7C15ull); }
+    static int64_t b(int64_t i) { return i; }
+    static void print_f(int64_t i) { printf("%" PRId64 " %" PRId64 "\n", a(i), b(i)); }
+    template <class Os> static void print_os(Os& os, int64_t i) { os<<a(i)<<' '<<b(i)<<'\n'; }
+    static void print_std(int64_t i) { std::println("{} {}", a(i), b(i)); }
+    static void print_fmt(int64_t i) { fmt::println("{} {}", a(i), b(i)); }
+    static void print_fast(FastSink& out, int64_t i) { out.println("{} {}", a(i), b(i)); }
+    static void print_async(AsyncLogger& log, int64_t i) { ASYNC_LOG(log, "{} {}", a(i), b(i)); }
+    template <class Out> static Out format(Out out, int64_t i) { return std::format_to(out, "{} {}\n", a(i), b(i)); }
+};
+
+struct Mixed {
+    static constexpr const char* name = "mixed";
+    static constexpr std::array<const char*, 4> names = {"alpha", "beta", "gamma", "delta"};
+    static const char* who(int64_t i) { return names[size_t(i) & 3]; }
+    static double value(int64_t i) { return double(i) * 0.25; }
+    static void print_f(int64_t i) {
+        printf("id=%d name=%s value=%.3f total=%" PRId64 "\n", int(i & 0xFFFF), who(i), value(i), i * 1000);
+    }
+    template <class Os> static void print_os(Os& os, int64_t i) {
+        os<<"id="<<int(i & 0xFFFF)<<" name="<<who(i)<<" value="<<std::fixed<<std::setprecision(3)<<value(i)
+          <<" total="<<i * 1000<<'\n';
+    }
+    static void print_std(int64_t i) {
+        std::println("id={} name={} value={:.3f} total={}", int(i & 0xFFFF), who(i), value(i), i * 1000);
+    }
+    static void print_fmt(int64_t i) {
+        fmt::println("id={} name={} value={:.3f} total={}", int(i & 0xFFFF), who(i), value(i), i * 1000);
+    }
+    static void print_fast(FastSink& out, int64_t i) {
+        out.println("id={} name={} value={:.3f} total={}", int(i & 0xFFFF), who(i), value(i), i * 1000);
+    }
+    static void print_async(AsyncLogger& log, int64_t i) {
+        ASYNC_LOG(log, "id={} name={} value={:.3f} total={}", int(i & 0xFFFF), who(i), value(i), i * 1000);
+    }
+    template <class Out> static Out format(Out out, int64_t i) {
+        return std::format_to(out, "id={} name={} value={:.3f} total={}\n", int(i & 0xFFFF), who(i), value(i), i * 1000);
+    }
+};
+
+struct LongString {
+    static constexpr const char* name = "long_string";
+    // 256 characters; each line prints a different 200-character window of it
+    static const std::string& text() {
+        static const std::string s = [] {
+            std::string t;
+            while(t.size() < 256) {
+                t += "the quick brown fox jumps over the lazy dog ";
+            }
+            return t.substr(0, 256);
+        }();
+        return s;
+    }
+    static std::string_view line(int64_t i) { return std::string_view(text()).substr(size_t(i) % 56, 200); }
+    static void print_f(int64_t i) { printf("%.*s\n", 200, line(i).data()); }
+    template <class Os> static void print_os(Os& os, int64_t i) { os<<line(i)<<'\n'; }
+    static void print_std(int64_t i) { std::println("{}", line(i)); }
+    static void print_fmt(int64_t i) { fmt::println("{}", line(i)); }
+    static void print_fast(FastSink& out, int64_t i) { out.println("{}", line(i)); }
+    static void print_async(AsyncLogger& log, int64_t i) { ASYNC_LOG(log, "{}", line(i)); }
+    template <class Out> static Out format(Out out, int64_t i) { return std::format_to(out, "{}\n", line(i)); }
+};
+
+enum class Method { Printf, Cout, StdPrintln, FmtPrintln, FormatTo, FastSink, AsyncLog };
+
+const char* method_name(Method m) {
+    switch(m) {
+    case Method::Printf: return "printf";
+    case Method::Cout: return "cout";
+    case Method::StdPrintln: return "std_println";
+    case Method::FmtPrintln: return "fmt_println";
+    case Method::FormatTo: return "format_to";
+    case Method::FastSink: return "fast_sink";
+    case Method::AsyncLog: return "async_log";
+    }
+    return "?";
+}
+
+// One line of output for iteration i. format_to formats into a reused string and hands it to
+// stdio, the usual way to use it for output. FastSink uses one sink per thread on fd 1 and
+// flushes only when its buffer is nearly full. AsyncLog only queues the record; the logger's
+// thread formats and writes it.
+template <class Case, Method M>
+inline void emit(int64_t i, bool shared, std::string& line, FastSink& fast) {
+    if constexpr(M == Method::Printf) {
+        Case::print_f(i);
+    } else if constexpr(M == Method::Cout) {
+        if(shared) {
+            std::osyncstream out(std::cout);
+            Case::print_os(out, i);
+        } else {
+            Case::print_os(std::cout, i);
+        }
+    } else if constexpr(M == Method::StdPrintln) {
+        Case::print_std(i);
+    } else if constexpr(M == Method::FmtPrintln) {
+        Case::print_fmt(i);
+    } else if constexpr(M == Method::FastSink) {
+        Case::print_fast(fast, i);
+    } else if constexpr(M == Method::AsyncLog) {
+        Case::print_async(async_logger(), i);
+    } else {
+        line.clear();
+        Case::format(std::back_inserter(line), i);
+        fwrite(line.data(), 1, line.size(), stdout);
+    }
+}
+
+// Every thread's FastSink, and with AsyncLog everything queued, must reach the sink before thread 0
+// puts stdout back: each thread flushes, and thread 0 waits for the others and drains the logger.
+template <Method M>
+void finish_output(benchmark::State& state, FastSink& fast) {
+    static std::atomic<int> flushed{0};
+    fast.flush();
+    flushed.fetch_add(1);
+    if(state.thread_index() == 0) {
+        while(flushed.load() < state.threads()) {
+            std::this_thread::yield();
+        }
+        flushed.store(0);
+        if constexpr(M == Method::AsyncLog) {
+            async_logger().flush();
+        }
+    }
+}
+
+template <class Case, Method M>
+void run_matrix(benchmark::State& state, Sink sink) {
+    std::cout.sync_with_stdio(false);
+    std::unique_ptr<StdoutRedirect> redirect;
+    if(state.thread_index() == 0) {
+        redirect = std::make_unique<StdoutRedirect>(sink); // all threads wait at the loop until this is done
+    }
+    bool shared = state.threads() > 1;
+    std::string line;
+    FastSink fast(STDOUT_FILENO);
+    int64_t i = int64_t(state.thread_index()) << 40;
+    const int64_t first = i;
+    auto start = std::chrono::steady_clock::now();
+    for(auto _: state) {
+        emit<Case, M>(i++, shared, line, fast);
+    }
+    static std::atomic<int64_t> total_lines{0};
+    total_lines += i - first;
+    finish_output<M>(state, fast);
+    if(state.thread_index() == 0) {
+        if constexpr(M == Method::AsyncLog) {
+            // lines/s only counts queueing; this also counts formatting and writing every line
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            state.counters["sustained_lines/s"] = double(total_lines.load()) / seconds;
+        }
+        total_lines.store(0);
+        redirect.reset();
+    }
+    // bytes written, counted outside the timed loop
+    int64_t bytes = 0;
+    for(int64_t k = first; k < i; ++k) {
+        line.clear();
+        Case::format(std::back_inserter(line), k);
+        bytes += int64_t(line.size());
+    }
+    state.SetBytesProcessed(bytes);
+    state.counters["lines/s"] = benchmark::Counter(double(i - first), benchmark::Counter::kIsRate);
+}
+
+template <class Case, Method M>
+void register_method() {
+    const int max_threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    for(Sink sink: {Sink::DevNull, Sink::File, Sink::Pipe, Sink::Memory}) {
+        std::string name = std::string(Case::name) + "/" + method_name(M) + "/" + sink_name(sink);
+        benchmark::RegisterBenchmark(name.c_str(), [sink](benchmark::State& state) {
+            run_matrix<Case, M>(state, sink);
+        })->ThreadRange(1, max_threads)->UseRealTime();
+    }
+}
+
+template <class Case>
+void register_case() {
+    register_method<Case, Method::Printf>();
+    register_method<Case, Method::Cout>();
+    register_method<Case, Method::StdPrintln>();
+    register_method<Case, Method::FmtPrintln>();
+    register_method<Case, Method::FormatTo>();
+    register_method<Case, Method::FastSink>();
+    register_method<Case, Method::AsyncLog>();
+}
+
+// Log-linear latency histogram: exact below 32 ns, then 32 buckets per power of two, so a
+// percentile is within about 3% of the true value. Fixed size (15 KB) however long the run.
+class LatencyHistogram {
+public:
+    void add(uint64_t ns) {
+        ++counts_[index(ns)];
+        ++total_;
+        max_ = std::max(max_, ns);
+    }
+    // The middle of the bucket holding the p-quantile.
+    double percentile(double p) const {
+        uint64_t rank = std::min(total_ - 1, uint64_t(p * double(total_)));
+        uint64_t seen = 0;
+        for(size_t b = 0; b < BUCKETS; ++b) {
+            seen += counts_[b];
+            if(seen > rank) {
+                return std::min(double(max_), middle(b));
+            }
+        }
+        return double(max_);
+    }
+    uint64_t max() const { return max_; }
+
+    void merge(const LatencyHistogram& other) {
+        for(size_t b = 0; b < BUCKETS; ++b) {
+            counts_[b] += other.counts_[b];
+        }
+        total_ += other.total_;
+        max_ = std::max(max_, other.max_);
+    }
+private:
+    static constexpr int SUB_BITS = 5;
+    static constexpr size_t SUB = size_t(1) << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+    static size_t index(uint64_t v) {
+        if(v < SUB) {
+            return size_t(v);
+        }
+        int e = 63 - __builtin_clzll(v); // >= SUB_BITS
+        return size_t(e - SUB_BITS + 1) * SUB + size_t((v >> (e - SUB_BITS)) & (SUB - 1));
+    }
+    static double middle(size_t b) {
+        if(b < SUB) {
+            return double(b);
+        }
+        int e = int(b / SUB) + SUB_BITS - 1;
+        double width = std::ldexp(1.0, e - SUB_BITS);
+        return double(SUB + b % SUB) * width + width / 2;
+    }
+
+    uint64_t counts_[BUCKETS] = {};
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+};
+
+// Caller-side latency of one mixed line: the time each call keeps the calling thread, as
+// percentiles over every call of the run. Each thread fills its own histogram; they are merged
+// and thread 0 reports the result. Includes about 20 ns of clock reads.
+template <Method M>
+void run_latency(benchmark::State& state, Sink sink) {
+    std::cout.sync_with_stdio(false);
+    std::unique_ptr<StdoutRedirect> redirect;
+    if(state.thread_index() == 0) {
+        redirect = std::make_unique<StdoutRedirect>(sink);
+    }
+    bool shared = state.threads() > 1;
+    std::string line;
+    FastSink fast(STDOUT_FILENO);
+    auto histogram = std::make_unique<LatencyHistogram>();
+    int64_t i = int64_t(state.thread_index()) << 40;
+    for(auto _: state) {
+        auto t0 = std::chrono::steady_clock::now();
+        emit<Mixed, M>(i++, shared, line, fast);
+        histogram->add(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count()));
+    }
+    static std::mutex merge_mutex;
+    static LatencyHistogram* merged = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        if(!merged) {
+            merged = new LatencyHistogram;
+        }
+        merged->merge(*histogram);
+    }
+    finish_output<M>(state, fast); // on thread 0, returns once every thread has merged
+    if(state.thread_index() == 0) {
+        redirect.reset();
+        // set on thread 0 only: the other threads' counters are zero, so the sum is this value
+        state.counters["p50_ns"] = merged->percentile(0.5);
+        state.counters["p99_ns"] = merged->percentile(0.99);
+        state.counters["p99.9_ns"] = merged->percentile(0.999);
+        state.counters["max_ns"] = double(merged->max());
+        delete merged;
+        merged = nullptr;
+    }
+}
+
+template <Method M>
+void register_latency() {
+    const int max_threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    for(Sink sink: {Sink::DevNull, Sink::File, Sink::Pipe, Sink::Memory}) {
+        std::string name = std::string("latency/") + method_name(M) + "/" + sink_name(sink);
+        benchmark::RegisterBenchmark(name.c_str(), [sink](benchmark::State& state) {
+            run_latency<M>(state, sink);
+        })->ThreadRange(1, max_threads)->UseRealTime();
+    }
+}
+
+int main(int argc, char** argv) {
+    register_case<Doubles>();
+    register_case<Int64>();
+    register_case<Mixed>();
+    register_case<LongString>();
+    register_latency<Method::Printf>();
+    register_latency<Method::FmtPrintln>();
+    register_latency<Method::FastSink>();
+    register_latency<Method::AsyncLog>();
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
\ No newline at end of file
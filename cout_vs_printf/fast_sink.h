@@ -0,0 +1,230 @@
+#pragma once
+// FastSink: a buffered line writer for programs that print millions of lines per second.
+//   - one big user-space buffer, flushed with write(2) only when it is nearly full or on flush(),
+//     never per line
+//   - numbers are converted with std::to_chars: no locale, no printf format parsing
+//   - the format string is checked at compile time: "{}" for any argument, "{:.Nf}" for a fixed
+//     precision float, "{{" and "}}" for braces; a bad placeholder or a wrong argument count is a
+//     compile error
+//   - no locking: use one FastSink per thread. Sinks sharing an fd interleave at flush boundaries,
+//     which fall between lines unless a single line is longer than FLUSH_SLACK
+//
+//   FastSink out(1);
+//   out.println("id={} value={:.3f}", id, value);
+
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+template <class... Args>
+class FastFormat {
+public:
+    template <size_t N>
+    consteval FastFormat(const char (&s)[N]): str_(s, N - 1) {
+        check();
+    }
+    constexpr std::string_view get() const { return str_; }
+private:
+    consteval void check() const {
+        constexpr bool floating[] = {std::is_floating_point_v<std::remove_cvref_t<Args>>..., false};
+        size_t arg = 0;
+        for(size_t i = 0; i < str_.size(); ++i) {
+            if(str_[i] == '}') {
+                if(i + 1 >= str_.size() || str_[i + 1] != '}') {
+                    throw "unmatched } in format string";
+                }
+                ++i;
+            } else if(str_[i] == '{') {
+                if(i + 1 < str_.size() && str_[i + 1] == '{') {
+                    ++i;
+                    continue;
+                }
+                size_t close = str_.find('}', i);
+                if(close == std::string_view::npos) {
+                    throw "unterminated { in format string";
+                }
+                std::string_view spec = str_.substr(i + 1, close - i - 1);
+                if(!spec.empty()) {
+                    if(spec.size() < 4 || spec.substr(0, 2) != ":." || spec.back() != 'f'
+                       || spec.substr(2, spec.size() - 3).find_first_not_of("0123456789") != std::string_view::npos) {
+                        throw "only {} and {:.Nf} are supported";
+                    }
+                    if(arg >= sizeof...(Args) || !floating[arg]) {
+                        throw "{:.Nf} needs a floating point argument";
+                    }
+                }
+                ++arg;
+                i = close;
+            }
+        }
+        if(arg != sizeof...(Args)) {
+            throw "number of {} does not match the number of arguments";
+        }
+    }
+
+    std::string_view str_;
+};
+
+class FastSink {
+public:
+    static constexpr size_t FLUSH_SLACK = 4096; // flush once less than this is left after a line
+
+    explicit FastSink(int fd, size_t capacity = size_t(1) << 20)
+        : fd_(fd), capacity_(std::max(capacity, 2 * FLUSH_SLACK)), buf_(new char[capacity_]) {}
+    ~FastSink() {
+        flush();
+    }
+    FastSink(const FastSink&) = delete;
+    FastSink& operator=(const FastSink&) = delete;
+
+    template <class... Args>
+    void print(FastFormat<std::type_identity_t<Args>...> fmt, const Args&... args) {
+        std::string_view rest = fmt.get();
+        (put_next(rest, args), ...);
+        put_literal(rest);
+        maybe_flush();
+    }
+
+    template <class... Args>
+    void println(FastFormat<std::type_identity_t<Args>...> fmt, const Args&... args) {
+        std::string_view rest = fmt.get();
+        (put_next(rest, args), ...);
+        put_literal(rest);
+        reserve(1);
+        buf_[size_++] = '\n';
+        maybe_flush();
+    }
+
+    void write(std::string_view s) {
+        append(s);
+        maybe_flush();
+    }
+
+    // Writes out everything buffered so far.
+    void flush() {
+        write_all(buf_.get(), size_);
+        size_ = 0;
+    }
+
+    // False once a write(2) has failed; the data of that write is dropped.
+    bool ok() const { return ok_; }
+private:
+    void maybe_flush() {
+        if(capacity_ - size_ < FLUSH_SLACK) {
+            flush();
+        }
+    }
+
+    void reserve(size_t n) {
+        if(capacity_ - size_ < n) {
+            flush();
+        }
+    }
+
+    void append(std::string_view s) {
+        if(s.size() > capacity_ - size_) {
+            flush();
+            if(s.size() > capacity_) {
+                write_all(s.data(), s.size());
+                return;
+            }
+        }
+        std::memcpy(buf_.get() + size_, s.data(), s.size());
+        size_ += s.size();
+    }
+
+    // Copies the literal text before the next placeholder, turning {{ and }} into single braces.
+    void put_literal(std::string_view& rest, bool stop_at_placeholder = false) {
+        size_t i = 0;
+        while(i < rest.size()) {
+            size_t brace = rest.find_first_of("{}", i);
+            if(brace == std::string_view::npos) {
+                append(rest.substr(i));
+                i = rest.size();
+                break;
+            }
+            append(rest.substr(i, brace - i));
+            if(brace + 1 < rest.size() && rest[brace + 1] == rest[brace]) {
+                append(rest.substr(brace, 1));
+                i = brace + 2;
+            } else {
+                i = brace;
+                if(stop_at_placeholder) {
+                    break;
+                }
+                ++i;
+            }
+        }
+        rest.remove_prefix(i);
+    }
+
+    template <class T>
+    void put_next(std::string_view& rest, const T& value) {
+        put_literal(rest, true);
+        size_t close = rest.find('}');
+        int precision = -1;
+        if(close > 1) { // {:.Nf}
+            std::from_chars(rest.data() + 3, rest.data() + close - 1, precision);
+        }
+        rest.remove_prefix(close + 1);
+        put(value, precision);
+    }
+
+    template <class T>
+    void put(const T& value, int precision) {
+        if constexpr(std::is_same_v<T, bool>) {
+            append(value ? "true" : "false");
+        } else if constexpr(std::is_same_v<T, char>) {
+            append(std::string_view(&value, 1));
+        } else if constexpr(std::is_integral_v<T>) {
+            reserve(24);
+            size_ = size_t(std::to_chars(buf_.get() + size_, buf_.get() + capacity_, value).ptr - buf_.get());
+        } else if constexpr(std::is_floating_point_v<T>) {
+            // the longest fixed double is 309 integer digits plus the fraction
+            size_t need = precision < 0 ? 32 : 320 + size_t(precision);
+            if(need > capacity_) {
+                std::string tmp(need, '\0');
+                auto r = std::to_chars(tmp.data(), tmp.data() + need, value, std::chars_format::fixed, precision);
+                append(std::string_view(tmp.data(), size_t(r.ptr - tmp.data())));
+                return;
+            }
+            reserve(need);
+            char* first = buf_.get() + size_;
+            std::to_chars_result r = precision < 0
+                ? std::to_chars(first, buf_.get() + capacity_, value)
+                : std::to_chars(first, buf_.get() + capacity_, value, std::chars_format::fixed, precision);
+            size_ = size_t(r.ptr - buf_.get());
+        } else {
+            append(std::string_view(value));
+        }
+        (void)precision;
+    }
+
+    void write_all(const char* p, size_t n) {
+        while(n > 0 && ok_) {
+            ssize_t w = ::write(fd_, p, n);
+            if(w < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                ok_ = false;
+                break;
+            }
+            p += w;
+            n -= size_t(w);
+        }
+    }
+
+    int fd_;
+    size_t capacity_;
+    std::unique_ptr<char[]> buf_;
+    size_t size_ = 0;
+    bool ok_ = true;
+};
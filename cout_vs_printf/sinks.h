@@ -0,0 +1,141 @@
+#pragma once
+// Explicit destinations for stdout, so results don't depend on the terminal that runs the benchmark.
+// A StdoutRedirect points fd 1 at the sink for its lifetime; printf, std::cout, std::println and
+// fmt::println all end up writing to it.
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// File and Memory never hold much more than SinkFd::TRIM_BYTES (64 MiB) at a time; see SinkFd.
+enum class Sink { DevNull, File, Pipe, Memory };
+
+inline const char* sink_name(Sink sink) {
+    switch(sink) {
+    case Sink::DevNull: return "devnull";
+    case Sink::File: return "file";
+    case Sink::Pipe: return "pipe";
+    case Sink::Memory: return "memory";
+    }
+    return "?";
+}
+
+// Opens a fresh file descriptor for the sink:
+//   DevNull  /dev/null
+//   File     an unlinked regular file in /tmp
+//   Pipe     the write end of a pipe; a thread drains the read end until it is closed
+//   Memory   a memfd, a file that only lives in RAM (Linux); elsewhere the same as File
+// File and Memory are opened O_APPEND and a thread truncates them to 0 whenever they pass
+// TRIM_BYTES (checked every TRIM_PERIOD), so a run holds at most about TRIM_BYTES plus what the
+// benchmark writes in TRIM_PERIOD, instead of every byte it ever wrote, in /tmp or RAM.
+class SinkFd {
+public:
+    static constexpr off_t TRIM_BYTES = off_t(64) << 20;
+    static constexpr std::chrono::milliseconds TRIM_PERIOD{5};
+
+    explicit SinkFd(Sink sink) {
+        switch(sink) {
+        case Sink::DevNull:
+            fd_ = open("/dev/null", O_WRONLY);
+            break;
+        case Sink::Pipe: {
+            int fds[2];
+            if(pipe(fds) == 0) {
+                fd_ = fds[1];
+                int in = fds[0];
+                drain_ = std::thread([in] {
+                    char buf[1 << 16];
+                    while(read(in, buf, sizeof(buf)) > 0) {
+                    }
+                    close(in);
+                });
+            }
+            break;
+        }
+        case Sink::Memory:
+#if defined(__linux__)
+            fd_ = memfd_create("cout_vs_printf", 0);
+            break;
+#endif
+        case Sink::File: {
+            char path[] = "/tmp/cout_vs_printf_XXXXXX";
+            fd_ = mkstemp(path);
+            if(fd_ >= 0) {
+                unlink(path);
+            }
+            break;
+        }
+        }
+        if(fd_ < 0) {
+            perror("sink");
+            std::abort();
+        }
+        if(sink == Sink::File || sink == Sink::Memory) {
+            // with O_APPEND every write goes to the current end, so after a truncation the file
+            // restarts at 0 instead of growing a hole up to the old offset
+            fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_APPEND);
+            trim_ = std::thread([this] {
+                while(!stop_.load()) {
+                    std::this_thread::sleep_for(TRIM_PERIOD);
+                    struct stat st;
+                    if(fstat(fd_, &st) == 0 && st.st_size > TRIM_BYTES) {
+                        (void)ftruncate(fd_, 0);
+                    }
+                }
+            });
+        }
+    }
+    ~SinkFd() {
+        stop_.store(true);
+        if(trim_.joinable()) {
+            trim_.join();
+        }
+        close(fd_); // for a pipe this is EOF for the drain thread
+        if(drain_.joinable()) {
+            drain_.join();
+        }
+    }
+    SinkFd(const SinkFd&) = delete;
+    SinkFd& operator=(const SinkFd&) = delete;
+
+    int fd() const { return fd_; }
+private:
+    int fd_ = -1;
+    std::thread drain_;
+    std::thread trim_;
+    std::atomic<bool> stop_{false};
+};
+
+class StdoutRedirect {
+public:
+    explicit StdoutRedirect(Sink sink): sink_(sink) {
+        flush();
+        saved_ = dup(1);
+        dup2(sink_.fd(), 1);
+    }
+    ~StdoutRedirect() {
+        flush();
+        dup2(saved_, 1);
+        close(saved_);
+    }
+    StdoutRedirect(const StdoutRedirect&) = delete;
+    StdoutRedirect& operator=(const StdoutRedirect&) = delete;
+
+    static void flush() {
+        std::cout.flush();
+        fflush(stdout);
+    }
+private:
+    SinkFd sink_;
+    int saved_ = -1;
+};
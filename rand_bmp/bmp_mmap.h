@@ -0,0 +1,99 @@
+#ifndef BMP_MMAP_H
+#define BMP_MMAP_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "bmp_writer.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define BMP_HAVE_MMAP 1
+#endif
+
+// A BMP file sized up front and mapped into memory. Headers are copied into the mapping on
+// open(); generator threads then write pixel rows straight into the page cache through row(),
+// with no stream buffer and no write() copies. Padding bytes are never touched: the file is
+// extended with ftruncate, which reads back as zeros.
+// POSIX only; open() returns false where mmap is not available.
+class BMPMappedFile {
+public:
+    BMPMappedFile() = default;
+    ~BMPMappedFile() {
+        close();
+    }
+    BMPMappedFile(const BMPMappedFile&) = delete;
+    BMPMappedFile& operator=(const BMPMappedFile&) = delete;
+
+    bool open(const std::string& path, int width, int height) {
+        close();
+        BMPFileHeader file_header;
+        BMPInfoHeader info_header;
+        makeBMPHeaders(width, height, file_header, info_header);
+        stride_ = bmpStride(width);
+        offset_ = file_header.offset_data;
+        size_ = offset_ + stride_ * size_t(height);
+#ifdef BMP_HAVE_MMAP
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            return false;
+        }
+        if (::ftruncate(fd_, off_t(size_)) != 0) {
+            close();
+            return false;
+        }
+#ifdef __linux__
+        // Reserve the blocks now so a full disk fails here instead of as SIGBUS in a generator thread.
+        // Filesystems without fallocate keep the sparse file.
+        int err = ::posix_fallocate(fd_, 0, off_t(size_));
+        if (err != 0 && err != EOPNOTSUPP && err != EINVAL) {
+            close();
+            return false;
+        }
+#endif
+        void* p = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            close();
+            return false;
+        }
+        base_ = static_cast<uint8_t*>(p);
+        std::memcpy(base_, &file_header, sizeof(file_header));
+        std::memcpy(base_ + sizeof(file_header), &info_header, sizeof(info_header));
+        return true;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    // Unmaps and closes; dirty pages are written back by the kernel.
+    void close() {
+#ifdef BMP_HAVE_MMAP
+        if (base_) {
+            ::munmap(base_, size_);
+            base_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+#endif
+    }
+
+    // Row y in file order (bottom row first).
+    uint8_t* row(size_t y) { return base_ + offset_ + y * stride_; }
+    size_t stride() const { return stride_; }
+    size_t size() const { return size_; }
+private:
+    uint8_t* base_ = nullptr;
+    int fd_ = -1;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    size_t stride_ = 0;
+};
+
+#endif // BMP_MMAP_H
@@ -0,0 +1,379 @@
+#ifndef BMP_PIPELINE_H
+#define BMP_PIPELINE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bmp_reader.h"
+#include "bmp_writer.h"
+
+// Streaming BMP transform: read -> kernels -> write, a strip of rows at a time.
+//
+// A reader thread cuts the input into strips and hands them to a pool of workers through a bounded
+// queue; each worker runs every kernel on its strip while the reader is already reading the next
+// ones, and the calling thread writes finished strips back in order. At most `in_flight` strips
+// exist at any time, so memory stays constant however large the image is.
+//
+// Kernels that look at neighbouring rows (blur) declare a radius. Every strip is read with that many
+// extra context rows above and below, and each such kernel consumes its share, so strips never need
+// to talk to each other. Row-local kernels (gray, invert, threshold) also process the context rows.
+
+// Rows of BGR8 pixels without padding: `rows` image rows starting at first_row (file order), with
+// `above` context rows before them and `below` after them in data.
+struct Strip {
+    size_t seq = 0;
+    size_t first_row = 0;
+    size_t rows = 0;
+    size_t above = 0;
+    size_t below = 0;
+    int width = 0;
+    std::vector<uint8_t> data;
+
+    size_t stride() const { return size_t(width) * 3; }
+    size_t total() const { return above + rows + below; }
+    uint8_t* row(size_t i) { return data.data() + i * stride(); } // i counts the context rows too
+};
+
+class Kernel {
+public:
+    virtual ~Kernel() = default;
+    // Context rows needed on each side.
+    virtual int radius() const { return 0; }
+    // Size of the output image for an input of width x height.
+    virtual void outputSize(int& width, int& height) const { (void)width; (void)height; }
+    // Transforms the strip in place or replaces its data; image_height is the input height.
+    virtual void apply(Strip& strip, size_t image_height) const = 0;
+};
+
+// Luma with BT.601 weights, written to all three channels.
+class GrayKernel: public Kernel {
+public:
+    void apply(Strip& strip, size_t) const override {
+        uint8_t* p = strip.data.data();
+        for (size_t i = 0, n = strip.total() * size_t(strip.width); i < n; ++i, p += 3) {
+            uint8_t y = uint8_t((29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8);
+            p[0] = p[1] = p[2] = y;
+        }
+    }
+};
+
+class InvertKernel: public Kernel {
+public:
+    void apply(Strip& strip, size_t) const override {
+        for (uint8_t& b: strip.data) {
+            b = uint8_t(255 - b);
+        }
+    }
+};
+
+// Pixels whose luma is at least `level` become white, the rest black.
+class ThresholdKernel: public Kernel {
+public:
+    explicit ThresholdKernel(int level): level_(level) {}
+    void apply(Strip& strip, size_t) const override {
+        uint8_t* p = strip.data.data();
+        for (size_t i = 0, n = strip.total() * size_t(strip.width); i < n; ++i, p += 3) {
+            int y = (29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8;
+            p[0] = p[1] = p[2] = y >= level_ ? 255 : 0;
+        }
+    }
+private:
+    int level_;
+};
+
+// 3x3 box blur, clamping at the image border. Consumes one context row on each side except
+// where the strip already touches the top or bottom of the image.
+class BlurKernel: public Kernel {
+public:
+    int radius() const override { return 1; }
+    void apply(Strip& strip, size_t image_height) const override {
+        bool top_edge = strip.first_row == strip.above;
+        bool bottom_edge = strip.first_row + strip.rows + strip.below == image_height;
+        size_t total = strip.total();
+        size_t lo = top_edge ? 0 : 1;
+        size_t hi = bottom_edge ? total : total - 1;
+        size_t stride = strip.stride();
+        int w = strip.width;
+        std::vector<uint8_t> out((hi - lo) * stride);
+        std::vector<uint16_t> column(stride); // vertical sums of three rows
+        for (size_t r = lo; r < hi; ++r) {
+            const uint8_t* up = strip.row(r > 0 ? r - 1 : 0);
+            const uint8_t* mid = strip.row(r);
+            const uint8_t* down = strip.row(r + 1 < total ? r + 1 : total - 1);
+            for (size_t i = 0; i < stride; ++i) {
+                column[i] = uint16_t(up[i] + mid[i] + down[i]);
+            }
+            uint8_t* dst = out.data() + (r - lo) * stride;
+            for (int x = 0; x < w; x += std::max(w - 1, 1)) { // first and last pixel clamp at the border
+                int left = std::max(x - 1, 0) * 3;
+                int right = std::min(x + 1, w - 1) * 3;
+                for (int c = 0; c < 3; ++c) {
+                    dst[x * 3 + c] = uint8_t((column[left + c] + column[x * 3 + c] + column[right + c] + 4) / 9);
+                }
+            }
+            for (size_t i = 3; i + 3 < stride; ++i) {
+                dst[i] = uint8_t((column[i - 3] + column[i] + column[i + 3] + 4) / 9);
+            }
+        }
+        strip.data.swap(out);
+        strip.above -= lo;
+        strip.below -= total - hi;
+    }
+};
+
+// Nearest-neighbour resize. Output row j samples input row (2j + 1) * h / 2h', so each strip maps to
+// a contiguous run of output rows. Must be the last kernel: it drops the context rows.
+class ResizeKernel: public Kernel {
+public:
+    ResizeKernel(int width, int height): width_(width), height_(height) {}
+    void outputSize(int& width, int& height) const override {
+        width = width_;
+        height = height_;
+    }
+    void apply(Strip& strip, size_t image_height) const override {
+        uint64_t h = image_height;
+        size_t begin = firstOutputRow(strip.first_row, h);
+        size_t end = firstOutputRow(strip.first_row + strip.rows, h);
+        std::vector<size_t> src_x(width_);
+        for (int i = 0; i < width_; ++i) {
+            src_x[i] = size_t((2 * uint64_t(i) + 1) * uint64_t(strip.width) / (2 * uint64_t(width_))) * 3;
+        }
+        std::vector<uint8_t> out((end - begin) * size_t(width_) * 3);
+        for (size_t j = begin; j < end; ++j) {
+            size_t src = size_t((2 * uint64_t(j) + 1) * h / (2 * uint64_t(height_)));
+            const uint8_t* in = strip.row(strip.above + src - strip.first_row);
+            uint8_t* dst = out.data() + (j - begin) * size_t(width_) * 3;
+            for (int i = 0; i < width_; ++i) {
+                std::memcpy(dst + i * 3, in + src_x[i], 3);
+            }
+        }
+        strip.data.swap(out);
+        strip.first_row = begin;
+        strip.rows = end - begin;
+        strip.above = 0;
+        strip.below = 0;
+        strip.width = width_;
+    }
+private:
+    // The first output row whose source row is at least `row`.
+    size_t firstOutputRow(uint64_t row, uint64_t h) const {
+        if (row >= h) {
+            return size_t(height_);
+        }
+        int64_t num = int64_t(2 * row * uint64_t(height_)) - int64_t(h);
+        return num <= 0 ? 0 : size_t((uint64_t(num) + 2 * h - 1) / (2 * h));
+    }
+
+    int width_;
+    int height_;
+};
+
+// "gray", "invert", "blur", "threshold=128", "resize=640x480"; nullptr for anything else.
+inline std::unique_ptr<Kernel> makeKernel(const std::string& spec) {
+    std::string name = spec.substr(0, spec.find('='));
+    std::string arg = name.size() < spec.size() ? spec.substr(name.size() + 1) : "";
+    if (name == "gray") {
+        return std::unique_ptr<Kernel>(new GrayKernel);
+    }
+    if (name == "invert") {
+        return std::unique_ptr<Kernel>(new InvertKernel);
+    }
+    if (name == "blur") {
+        return std::unique_ptr<Kernel>(new BlurKernel);
+    }
+    if (name == "threshold") {
+        return std::unique_ptr<Kernel>(new ThresholdKernel(arg.empty() ? 128 : atoi(arg.c_str())));
+    }
+    if (name == "resize") {
+        int w = atoi(arg.c_str());
+        size_t x = arg.find('x');
+        int h = x == std::string::npos ? 0 : atoi(arg.c_str() + x + 1);
+        if (w > 0 && h > 0) {
+            return std::unique_ptr<Kernel>(new ResizeKernel(w, h));
+        }
+    }
+    return nullptr;
+}
+
+// A queue that blocks pop() while empty; close() wakes everybody up and makes pop() return false
+// once the queue has drained. Bounding happens outside, through the in-flight limit.
+template <class T>
+class WorkQueue {
+public:
+    void push(T item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        items_.push_back(std::move(item));
+        cv_.notify_one();
+    }
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !items_.empty() || closed_; });
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        return true;
+    }
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        cv_.notify_all();
+    }
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+class BMPPipeline {
+public:
+    // Resize has to come last; false otherwise.
+    bool add(std::unique_ptr<Kernel> kernel) {
+        if (!kernels_.empty() && dynamic_cast<ResizeKernel*>(kernels_.back().get())) {
+            return false;
+        }
+        kernels_.push_back(std::move(kernel));
+        return true;
+    }
+
+    // Runs the kernels over `in` and writes `out` with `threads` workers, strip_rows image rows per strip.
+    bool run(const std::string& in, const std::string& out, unsigned threads,
+             size_t strip_rows = 64, std::string* error = nullptr) {
+        BMPStreamReader reader;
+        if (!reader.open(in)) {
+            if (error) {
+                *error = reader.error();
+            }
+            return false;
+        }
+        threads = std::max(1u, threads);
+        strip_rows = std::max<size_t>(1, strip_rows);
+        const int width = reader.width();
+        const size_t height = size_t(reader.height());
+        size_t halo = 0;
+        int out_width = width;
+        int out_height = reader.height();
+        for (const auto& k: kernels_) {
+            halo += size_t(k->radius());
+            k->outputSize(out_width, out_height);
+        }
+        const size_t strips = (height + strip_rows - 1) / strip_rows;
+        const size_t in_flight = 2 * size_t(threads) + 2;
+
+        // The reader may only start a strip while fewer than in_flight strips are unwritten.
+        std::mutex slots_mutex;
+        std::condition_variable slots_cv;
+        size_t written = 0;
+        bool read_ok = true;
+        WorkQueue<Strip> todo;
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        std::map<size_t, Strip> done;
+
+        std::thread read_thread([&] {
+            const size_t stride = size_t(width) * 3;
+            std::vector<uint8_t> tail; // the last rows read, for the next strip's context rows
+            size_t read_pos = 0;
+            for (size_t seq = 0; seq < strips; ++seq) {
+                {
+                    std::unique_lock<std::mutex> lock(slots_mutex);
+                    slots_cv.wait(lock, [&] { return seq < written + in_flight; });
+                }
+                Strip s;
+                s.seq = seq;
+                s.width = width;
+                s.first_row = seq * strip_rows;
+                s.rows = std::min(strip_rows, height - s.first_row);
+                s.above = std::min(halo, s.first_row);
+                s.below = std::min(halo, height - s.first_row - s.rows);
+                s.data.resize(s.total() * stride);
+                size_t begin = s.first_row - s.above;
+                size_t end = s.first_row + s.rows + s.below;
+                size_t carried = read_pos - begin; // rows [begin, read_pos) are already in tail
+                if (carried > 0) {
+                    std::memcpy(s.data.data(), tail.data() + tail.size() - carried * stride, carried * stride);
+                }
+                if (!reader.readRows(s.row(carried), stride, end - read_pos)) {
+                    read_ok = false;
+                }
+                read_pos = end;
+                size_t keep = std::min(2 * halo, s.total());
+                tail.assign(s.data.end() - std::ptrdiff_t(keep * stride), s.data.end());
+                todo.push(std::move(s));
+            }
+            todo.close();
+        });
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                Strip s;
+                while (todo.pop(s)) {
+                    for (const auto& k: kernels_) {
+                        k->apply(s, height);
+                    }
+                    std::lock_guard<std::mutex> lock(done_mutex);
+                    size_t seq = s.seq;
+                    done[seq] = std::move(s);
+                    done_cv.notify_all();
+                }
+            });
+        }
+
+        // write finished strips in order on this thread
+        std::ofstream file(out, std::ios::out | std::ios::binary);
+        BMPFileHeader file_header;
+        BMPInfoHeader info_header;
+        makeBMPHeaders(out_width, out_height, file_header, info_header);
+        file.write((const char*)&file_header, sizeof(file_header));
+        file.write((const char*)&info_header, sizeof(info_header));
+        const char padding[3] = {0, 0, 0};
+        const size_t pad = bmpStride(out_width) - size_t(out_width) * 3;
+        for (size_t seq = 0; seq < strips; ++seq) {
+            Strip s;
+            {
+                std::unique_lock<std::mutex> lock(done_mutex);
+                done_cv.wait(lock, [&] { return done.count(seq) != 0; });
+                s = std::move(done[seq]);
+                done.erase(seq);
+            }
+            for (size_t r = 0; r < s.rows; ++r) {
+                file.write((const char*)s.row(s.above + r), std::streamsize(s.stride()));
+                file.write(padding, std::streamsize(pad));
+            }
+            {
+                std::lock_guard<std::mutex> lock(slots_mutex);
+                ++written;
+                slots_cv.notify_all();
+            }
+        }
+        read_thread.join();
+        for (std::thread& th: workers) {
+            th.join();
+        }
+        file.close();
+        if (error && !read_ok) {
+            *error = in + ": unexpected end of file";
+        } else if (error && !file) {
+            *error = "unable to write " + out;
+        }
+        return read_ok && bool(file);
+    }
+private:
+    std::vector<std::unique_ptr<Kernel>> kernels_;
+};
+
+#endif // BMP_PIPELINE_H
@@ -0,0 +1,57 @@
+#ifndef BMP_READER_H
+#define BMP_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "bmp_writer.h"
+
+// Reads the uncompressed 24-bit bottom-up BMPs that BMPStreamWriter and BMPMappedFile produce,
+// a few rows at a time. Rows come back in file order (bottom row first) without padding.
+class BMPStreamReader {
+public:
+    // False if the file is missing or not a 24-bit BI_RGB bottom-up bitmap; error() says why.
+    bool open(const std::string& path) {
+        file_.open(path, std::ios::in | std::ios::binary);
+        if (!file_) {
+            error_ = "unable to open " + path;
+            return false;
+        }
+        BMPFileHeader file_header;
+        file_.read((char*)&file_header, sizeof(file_header));
+        file_.read((char*)&info_, sizeof(info_));
+        if (!file_ || file_header.file_type != 0x4D42) {
+            error_ = path + " is not a BMP file";
+            return false;
+        }
+        if (info_.bit_count != 24 || info_.compression != 0 || info_.width <= 0 || info_.height <= 0) {
+            error_ = path + ": only uncompressed 24-bit bottom-up bitmaps are supported";
+            return false;
+        }
+        file_.seekg(file_header.offset_data);
+        padding_.resize(bmpStride(info_.width) - size_t(info_.width) * 3);
+        return bool(file_);
+    }
+
+    int width() const { return info_.width; }
+    int height() const { return info_.height; }
+    const std::string& error() const { return error_; }
+
+    // Reads the next `rows` rows into dst, stride bytes apart; false on a short read.
+    bool readRows(uint8_t* dst, size_t stride, size_t rows) {
+        for (size_t r = 0; r < rows; ++r) {
+            file_.read((char*)dst + r * stride, std::streamsize(info_.width) * 3);
+            file_.read(padding_.data(), std::streamsize(padding_.size()));
+        }
+        return bool(file_);
+    }
+private:
+    std::ifstream file_;
+    BMPInfoHeader info_;
+    std::vector<char> padding_;
+    std::string error_;
+};
+
+#endif // BMP_READER_H
@@ -0,0 +1,190 @@
+#ifndef BMP_WRITER_H
+#define BMP_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma pack(push, 1)
+
+struct BMPFileHeader {
+    uint16_t file_type{0x4D42};
+    uint32_t file_size{0};
+    uint16_t reserved1{0};
+    uint16_t reserved2{0};
+    uint32_t offset_data{0};
+};
+
+struct BMPInfoHeader {
+    uint32_t size{0};
+    int32_t width{0};
+    int32_t height{0};
+    uint16_t planes{1};
+    uint16_t bit_count{0};
+    uint32_t compression{0};
+    uint32_t size_image{0};
+    int32_t x_pixels_per_meter{0};
+    int32_t y_pixels_per_meter{0};
+    uint32_t colors_used{0};
+    uint32_t colors_important{0};
+};
+#pragma pack(pop)
+
+// Each row of a 24-bit BMP is padded to a multiple of 4 bytes.
+inline size_t bmpStride(int width) {
+    return (size_t(width) * 3 + 3) & ~size_t(3);
+}
+
+// Headers for a 24-bit bottom-up BMP. The size fields are 32 bits; past 4 GB they are
+// left 0, which BI_RGB readers accept for size_image and most ignore for file_size.
+inline void makeBMPHeaders(int width, int height, BMPFileHeader& file_header, BMPInfoHeader& info_header) {
+    info_header.size = sizeof(BMPInfoHeader);
+    info_header.width = width;
+    info_header.height = height;
+    info_header.bit_count = 24;
+    file_header.offset_data = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader);
+    uint64_t image_size = uint64_t(bmpStride(width)) * uint64_t(height);
+    if (image_size + file_header.offset_data <= UINT32_MAX) {
+        info_header.size_image = uint32_t(image_size);
+        file_header.file_size = uint32_t(file_header.offset_data + image_size);
+    }
+}
+
+// Writes a 24-bit BMP row by row without ever holding the whole image.
+// The producer fills chunks of padded rows in file order (bottom row first) while a writer
+// thread writes earlier chunks to disk; at most `buffers` chunks of about chunk_bytes exist
+// at once, so memory stays constant however large the image is.
+//
+//   BMPStreamWriter writer("out.bmp", width, height);
+//   while (BMPStreamWriter::Chunk* c = writer.nextChunk()) {
+//       for (size_t r = 0; r < c->rows; ++r) fill(c->row(r), c->first_row + r);
+//       writer.submit(c);
+//   }
+//   bool ok = writer.finish();
+class BMPStreamWriter {
+public:
+    struct Chunk {
+        size_t first_row = 0;
+        size_t rows = 0;
+        size_t stride = 0;
+        std::vector<uint8_t> data; // padding bytes stay zero: producers only write width * 3 per row
+
+        uint8_t* row(size_t r) { return data.data() + r * stride; }
+    };
+
+    BMPStreamWriter(const std::string& path, int width, int height,
+                    size_t chunk_bytes = size_t(4) << 20, size_t buffers = 3)
+        : stride_(bmpStride(width)) {
+        // an empty or negative size has no rows to write: finish() reports failure, no file is created
+        if (width <= 0 || height <= 0) {
+            return;
+        }
+        height_ = size_t(height);
+        chunk_rows_ = std::max<size_t>(1, std::min(height_, chunk_bytes / stride_));
+        file_.open(path, std::ios::out | std::ios::binary);
+        BMPFileHeader file_header;
+        BMPInfoHeader info_header;
+        makeBMPHeaders(width, height, file_header, info_header);
+        file_.write((const char*)&file_header, sizeof(file_header));
+        file_.write((const char*)&info_header, sizeof(info_header));
+        // a small image needs fewer and smaller buffers than the defaults
+        const size_t chunks_needed = (height_ + chunk_rows_ - 1) / chunk_rows_;
+        chunks_.resize(std::max<size_t>(1, std::min(buffers, chunks_needed)));
+        for (Chunk& c: chunks_) {
+            c.stride = stride_;
+            c.data.assign(chunk_rows_ * stride_, 0);
+            free_.push_back(&c);
+        }
+        writer_ = std::thread([this] { writeLoop(); });
+    }
+
+    ~BMPStreamWriter() {
+        finish();
+    }
+
+    BMPStreamWriter(const BMPStreamWriter&) = delete;
+    BMPStreamWriter& operator=(const BMPStreamWriter&) = delete;
+
+    // The next chunk of rows to fill, or nullptr when every row has been handed out.
+    // Blocks while all buffers are waiting to be written.
+    Chunk* nextChunk() {
+        if (next_row_ >= height_) {
+            return nullptr;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !free_.empty(); });
+        Chunk* c = free_.front();
+        free_.pop_front();
+        c->first_row = next_row_;
+        c->rows = std::min(chunk_rows_, height_ - next_row_);
+        next_row_ += c->rows;
+        return c;
+    }
+
+    // Chunks must be submitted in the order nextChunk() returned them.
+    void submit(Chunk* c) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        full_.push_back(c);
+        cv_.notify_all();
+    }
+
+    // Waits for the writer thread to drain; false if the file could not be written.
+    bool finish() {
+        if (writer_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_ = true;
+                cv_.notify_all();
+            }
+            writer_.join();
+            file_.close();
+        }
+        return ok_;
+    }
+
+    size_t stride() const { return stride_; }
+private:
+    void writeLoop() {
+        for (;;) {
+            Chunk* c;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return !full_.empty() || done_; });
+                if (full_.empty()) {
+                    break;
+                }
+                c = full_.front();
+                full_.pop_front();
+            }
+            file_.write((const char*)c->data.data(), std::streamsize(c->rows * stride_));
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                free_.push_back(c);
+                cv_.notify_all();
+            }
+        }
+        ok_ = bool(file_);
+    }
+
+    size_t stride_;
+    size_t height_ = 0;
+    size_t chunk_rows_ = 1;
+    size_t next_row_ = 0;
+    std::ofstream file_;
+    std::vector<Chunk> chunks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Chunk*> free_;
+    std::deque<Chunk*> full_;
+    bool done_ = false;
+    bool ok_ = false;
+    std::thread writer_;
+};
+
+#endif // BMP_WRITER_H
@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "patterns.h"
+#include "image_encoders.h"
+
+// Encode throughput and output size of each format on a square image, for noise (incompressible)
+// and a gradient (long runs, small deltas). bytes_per_second counts input pixels (3 bytes each);
+// the "ratio" counter is output size / raw size.
+
+static std::vector<uint8_t> makeImage(Pattern pattern, int size) {
+    std::vector<uint8_t> pixels(size_t(size) * size * 3);
+    fillRows(pattern, pixels.data(), size, size_t(size) * 3, size_t(size), 0, size, 1, 1);
+    return pixels;
+}
+
+static ImageView viewOf(const std::vector<uint8_t>& pixels, int size) {
+    ImageView view;
+    view.data = pixels.data();
+    view.width = size;
+    view.rows = size_t(size);
+    view.stride = size_t(size) * 3;
+    view.bottom_up = true;
+    return view;
+}
+
+static void encode(benchmark::State& state, const std::string& format, Pattern pattern) {
+    const int size = int(state.range(0));
+    std::vector<uint8_t> pixels = makeImage(pattern, size);
+    ImageView view = viewOf(pixels, size);
+    std::vector<uint8_t> out;
+    for (auto _: state) {
+        out.clear();
+        if (format == "bmp") {
+            encodeBMP(view, out);
+        } else {
+            std::unique_ptr<ImageEncoder> encoder = makeEncoder(format);
+            encoder->begin(size, size, out);
+            encoder->addRows(view, out);
+            encoder->end(out);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(pixels.size()));
+    state.counters["ratio"] = double(out.size()) / double(pixels.size());
+}
+
+static void BM_noise_bmp(benchmark::State& state) { encode(state, "bmp", Pattern::Noise); }
+static void BM_noise_ppm(benchmark::State& state) { encode(state, "ppm", Pattern::Noise); }
+static void BM_noise_qoi(benchmark::State& state) { encode(state, "qoi", Pattern::Noise); }
+static void BM_noise_png(benchmark::State& state) { encode(state, "png", Pattern::Noise); }
+static void BM_gradient_bmp(benchmark::State& state) { encode(state, "bmp", Pattern::HSVGradient); }
+static void BM_gradient_ppm(benchmark::State& state) { encode(state, "ppm", Pattern::HSVGradient); }
+static void BM_gradient_qoi(benchmark::State& state) { encode(state, "qoi", Pattern::HSVGradient); }
+static void BM_gradient_png(benchmark::State& state) { encode(state, "png", Pattern::HSVGradient); }
+
+BENCHMARK(BM_noise_bmp)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_noise_ppm)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_noise_qoi)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_noise_png)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_gradient_bmp)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_gradient_ppm)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_gradient_qoi)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_gradient_png)->Arg(256)->Arg(1024)->Arg(4096);
+
+BENCHMARK_MAIN();
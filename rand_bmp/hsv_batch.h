@@ -0,0 +1,121 @@
+#ifndef HSV_BATCH_H
+#define HSV_BATCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Batch HSV -> packed BGR8 over structure-of-arrays input: h in degrees [0, 360], s and v in [0, 1].
+// Instead of picking one of six sectors with a switch, every channel is computed with the same
+// formula, c(n) = v - v * s * clamp(min(k, 4 - k), 0, 1) with k = (n + h / 60) mod 6 and
+// n = 5, 3, 1 for r, g, b, so all lanes of a vector take the same path.
+// The instruction set is chosen at compile time (-mavx2, SSE2 on any x86-64, plain C++ elsewhere);
+// all paths round c * 255 + 0.5 down, and agree to within 1 when the compiler fuses multiply-adds.
+
+inline float hsvChannel(float n, float h6, float s, float v) {
+    float k = n + h6;
+    k -= 6.0f * float(int(k * (1.0f / 6.0f)));
+    float t = std::max(std::min(std::min(k, 4.0f - k), 1.0f), 0.0f);
+    return v - v * s * t;
+}
+
+inline uint8_t toByte(float c) {
+    return uint8_t(int(c * 255.0f + 0.5f));
+}
+
+inline void hsv2rgbBatchScalar(const float* h, const float* s, const float* v, size_t n, uint8_t* bgr) {
+    for (size_t i = 0; i < n; ++i) {
+        float h6 = h[i] * (1.0f / 60.0f);
+        bgr[i * 3 + 0] = toByte(hsvChannel(1.0f, h6, s[i], v[i]));
+        bgr[i * 3 + 1] = toByte(hsvChannel(3.0f, h6, s[i], v[i]));
+        bgr[i * 3 + 2] = toByte(hsvChannel(5.0f, h6, s[i], v[i]));
+    }
+}
+
+#if defined(__AVX2__)
+
+inline __m256i hsvChannel8(__m256 n, __m256 h6, __m256 vs, __m256 v) {
+    __m256 k = _mm256_add_ps(n, h6);
+    __m256 q = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_mul_ps(k, _mm256_set1_ps(1.0f / 6.0f))));
+    k = _mm256_sub_ps(k, _mm256_mul_ps(q, _mm256_set1_ps(6.0f)));
+    __m256 t = _mm256_min_ps(_mm256_min_ps(k, _mm256_sub_ps(_mm256_set1_ps(4.0f), k)), _mm256_set1_ps(1.0f));
+    t = _mm256_max_ps(t, _mm256_setzero_ps());
+    __m256 c = _mm256_sub_ps(v, _mm256_mul_ps(vs, t));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(c, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+}
+
+inline void hsv2rgbBatch(const float* h, const float* s, const float* v, size_t n, uint8_t* bgr) {
+    // per 128-bit lane, after packing: b0-3 g0-3 r0-3 0000 -> b0 g0 r0 b1 g1 r1 ... r3
+    const __m256i interleave = _mm256_setr_epi8(
+        0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1,
+        0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 h6 = _mm256_mul_ps(_mm256_loadu_ps(h + i), _mm256_set1_ps(1.0f / 60.0f));
+        __m256 vv = _mm256_loadu_ps(v + i);
+        __m256 vs = _mm256_mul_ps(vv, _mm256_loadu_ps(s + i));
+        __m256i b = hsvChannel8(_mm256_set1_ps(1.0f), h6, vs, vv);
+        __m256i g = hsvChannel8(_mm256_set1_ps(3.0f), h6, vs, vv);
+        __m256i r = hsvChannel8(_mm256_set1_ps(5.0f), h6, vs, vv);
+        __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(b, g), _mm256_packs_epi32(r, _mm256_setzero_si256()));
+        bytes = _mm256_shuffle_epi8(bytes, interleave);
+        uint8_t* out = bgr + i * 3;
+        __m128i lo = _mm256_castsi256_si128(bytes);
+        __m128i hi = _mm256_extracti128_si256(bytes, 1);
+        _mm_storeu_si128((__m128i*)out, lo); // bytes 12-15 are overwritten below
+        _mm_storel_epi64((__m128i*)(out + 12), hi);
+        int tail = _mm_cvtsi128_si32(_mm_srli_si128(hi, 8));
+        std::memcpy(out + 20, &tail, 4);
+    }
+    hsv2rgbBatchScalar(h + i, s + i, v + i, n - i, bgr + i * 3);
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+inline __m128i hsvChannel4(__m128 n, __m128 h6, __m128 vs, __m128 v) {
+    __m128 k = _mm_add_ps(n, h6);
+    __m128 q = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(k, _mm_set1_ps(1.0f / 6.0f))));
+    k = _mm_sub_ps(k, _mm_mul_ps(q, _mm_set1_ps(6.0f)));
+    __m128 t = _mm_min_ps(_mm_min_ps(k, _mm_sub_ps(_mm_set1_ps(4.0f), k)), _mm_set1_ps(1.0f));
+    t = _mm_max_ps(t, _mm_setzero_ps());
+    __m128 c = _mm_sub_ps(v, _mm_mul_ps(vs, t));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+inline void hsv2rgbBatch(const float* h, const float* s, const float* v, size_t n, uint8_t* bgr) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 h6 = _mm_mul_ps(_mm_loadu_ps(h + i), _mm_set1_ps(1.0f / 60.0f));
+        __m128 vv = _mm_loadu_ps(v + i);
+        __m128 vs = _mm_mul_ps(vv, _mm_loadu_ps(s + i));
+        // b0-3 g0-3 r0-3 as bytes; SSE2 has no byte shuffle, so interleave through memory
+        alignas(16) uint8_t planar[16];
+        __m128i bg = _mm_packs_epi32(hsvChannel4(_mm_set1_ps(1.0f), h6, vs, vv),
+                                     hsvChannel4(_mm_set1_ps(3.0f), h6, vs, vv));
+        __m128i r = _mm_packs_epi32(hsvChannel4(_mm_set1_ps(5.0f), h6, vs, vv), _mm_setzero_si128());
+        _mm_store_si128((__m128i*)planar, _mm_packus_epi16(bg, r));
+        uint8_t* out = bgr + i * 3;
+        for (int l = 0; l < 4; ++l) {
+            out[l * 3 + 0] = planar[l];
+            out[l * 3 + 1] = planar[4 + l];
+            out[l * 3 + 2] = planar[8 + l];
+        }
+    }
+    hsv2rgbBatchScalar(h + i, s + i, v + i, n - i, bgr + i * 3);
+}
+
+#else
+
+inline void hsv2rgbBatch(const float* h, const float* s, const float* v, size_t n, uint8_t* bgr) {
+    hsv2rgbBatchScalar(h, s, v, n, bgr);
+}
+
+#endif
+
+#endif // HSV_BATCH_H
@@ -0,0 +1,326 @@
+#ifndef IMAGE_ENCODERS_H
+#define IMAGE_ENCODERS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bmp_writer.h"
+
+// Encoders for formats other than BMP, fed by the same BGR8 row buffers the generators fill.
+// They stream: begin() writes the header, addRows() may be called many times with rows in
+// top-to-bottom order, end() finishes the file. Each call appends to `out`, which the caller can
+// flush to disk and clear in between, so an image never has to be in memory all at once.
+
+// Rows of BGR8 pixels, stride bytes apart. With bottom_up the last row in memory is the top one,
+// as in a BMP chunk.
+struct ImageView {
+    const uint8_t* data = nullptr;
+    int width = 0;
+    size_t rows = 0;
+    size_t stride = 0;
+    bool bottom_up = false;
+
+    const uint8_t* row(size_t y) const { return data + (bottom_up ? rows - 1 - y : y) * stride; }
+};
+
+class ImageEncoder {
+public:
+    virtual ~ImageEncoder() = default;
+    virtual void begin(int width, int height, std::vector<uint8_t>& out) = 0;
+    virtual void addRows(const ImageView& rows, std::vector<uint8_t>& out) = 0;
+    virtual void end(std::vector<uint8_t>& out) { (void)out; }
+};
+
+// Binary PPM (P6): a text header and raw RGB.
+class PPMEncoder: public ImageEncoder {
+public:
+    void begin(int width, int height, std::vector<uint8_t>& out) override {
+        std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+        out.insert(out.end(), header.begin(), header.end());
+    }
+    void addRows(const ImageView& rows, std::vector<uint8_t>& out) override {
+        size_t n = size_t(rows.width) * 3;
+        size_t pos = out.size();
+        out.resize(pos + n * rows.rows);
+        uint8_t* dst = out.data() + pos;
+        for (size_t y = 0; y < rows.rows; ++y) {
+            const uint8_t* src = rows.row(y);
+            for (size_t i = 0; i < n; i += 3, dst += 3) {
+                dst[0] = src[i + 2];
+                dst[1] = src[i + 1];
+                dst[2] = src[i];
+            }
+        }
+    }
+};
+
+// QOI, "The Quite OK Image Format" (qoiformat.org), 3 channels: runs, a 64-entry hash of recently
+// seen pixels, small deltas, or the literal pixel. Lossless and one pass.
+class QOIEncoder: public ImageEncoder {
+public:
+    void begin(int width, int height, std::vector<uint8_t>& out) override {
+        const uint8_t magic[4] = {'q', 'o', 'i', 'f'};
+        out.insert(out.end(), magic, magic + 4);
+        putBE32(out, uint32_t(width));
+        putBE32(out, uint32_t(height));
+        out.push_back(3); // channels
+        out.push_back(0); // sRGB with linear alpha
+        std::memset(index_, 0, sizeof(index_));
+        prev_ = 0xFF000000u; // r = g = b = 0, a = 255
+        run_ = 0;
+    }
+    void addRows(const ImageView& rows, std::vector<uint8_t>& out) override {
+        out.reserve(out.size() + size_t(rows.width) * rows.rows * 4);
+        for (size_t y = 0; y < rows.rows; ++y) {
+            const uint8_t* p = rows.row(y);
+            for (int x = 0; x < rows.width; ++x, p += 3) {
+                uint32_t px = uint32_t(p[2]) | uint32_t(p[1]) << 8 | uint32_t(p[0]) << 16 | 0xFF000000u;
+                if (px == prev_) {
+                    if (++run_ == 62) {
+                        out.push_back(uint8_t(0xC0 | (run_ - 1)));
+                        run_ = 0;
+                    }
+                    continue;
+                }
+                flushRun(out);
+                uint8_t r = p[2], g = p[1], b = p[0];
+                int hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+                if (index_[hash] == px) {
+                    out.push_back(uint8_t(hash)); // QOI_OP_INDEX
+                } else {
+                    index_[hash] = px;
+                    int8_t dr = int8_t(r - uint8_t(prev_));
+                    int8_t dg = int8_t(g - uint8_t(prev_ >> 8));
+                    int8_t db = int8_t(b - uint8_t(prev_ >> 16));
+                    int8_t dr_dg = int8_t(dr - dg);
+                    int8_t db_dg = int8_t(db - dg);
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        out.push_back(uint8_t(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                    } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                        out.push_back(uint8_t(0x80 | (dg + 32)));
+                        out.push_back(uint8_t((dr_dg + 8) << 4 | (db_dg + 8)));
+                    } else {
+                        const uint8_t rgb[4] = {0xFE, r, g, b};
+                        out.insert(out.end(), rgb, rgb + 4);
+                    }
+                }
+                prev_ = px;
+            }
+        }
+    }
+    void end(std::vector<uint8_t>& out) override {
+        flushRun(out);
+        const uint8_t padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+        out.insert(out.end(), padding, padding + 8);
+    }
+private:
+    void flushRun(std::vector<uint8_t>& out) {
+        if (run_ > 0) {
+            out.push_back(uint8_t(0xC0 | (run_ - 1)));
+            run_ = 0;
+        }
+    }
+    static void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+        const uint8_t b[4] = {uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v)};
+        out.insert(out.end(), b, b + 4);
+    }
+
+    uint32_t index_[64];
+    uint32_t prev_ = 0xFF000000u;
+    int run_ = 0;
+};
+
+// PNG with stored (uncompressed) deflate blocks: no compression work at all, only the CRC-32 of
+// each chunk and the Adler-32 of the zlib stream. Every addRows() call becomes one IDAT chunk;
+// end() closes the deflate stream with an empty final block.
+class PNGEncoder: public ImageEncoder {
+public:
+    void begin(int width, int height, std::vector<uint8_t>& out) override {
+        const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        out.insert(out.end(), signature, signature + 8);
+        uint8_t ihdr[13] = {0};
+        putBE32(ihdr, uint32_t(width));
+        putBE32(ihdr + 4, uint32_t(height));
+        ihdr[8] = 8; // bits per channel
+        ihdr[9] = 2; // truecolour RGB
+        chunk(out, "IHDR", ihdr, sizeof(ihdr));
+        adler_a_ = 1;
+        adler_b_ = 0;
+        zlib_header_ = true;
+    }
+    void addRows(const ImageView& rows, std::vector<uint8_t>& out) override {
+        // filtered scanlines: filter type 0, then RGB
+        size_t line = size_t(rows.width) * 3 + 1;
+        raw_.resize(line * rows.rows);
+        uint8_t* dst = raw_.data();
+        for (size_t y = 0; y < rows.rows; ++y) {
+            const uint8_t* src = rows.row(y);
+            *dst++ = 0;
+            for (size_t i = 0; i + 1 < line; i += 3, dst += 3) {
+                dst[0] = src[i + 2];
+                dst[1] = src[i + 1];
+                dst[2] = src[i];
+            }
+        }
+        adler(raw_.data(), raw_.size());
+
+        size_t blocks = (raw_.size() + 65534) / 65535;
+        size_t start = beginChunk(out, "IDAT");
+        if (zlib_header_) {
+            out.push_back(0x78); // deflate, 32K window
+            out.push_back(0x01); // no preset dictionary, fastest; 0x7801 is divisible by 31
+            zlib_header_ = false;
+        }
+        out.reserve(out.size() + raw_.size() + blocks * 5 + 4);
+        for (size_t pos = 0; pos < raw_.size(); pos += 65535) {
+            uint16_t len = uint16_t(std::min<size_t>(65535, raw_.size() - pos));
+            const uint8_t header[5] = {0, uint8_t(len), uint8_t(len >> 8), uint8_t(~len), uint8_t(~len >> 8)};
+            out.insert(out.end(), header, header + 5);
+            out.insert(out.end(), raw_.begin() + std::ptrdiff_t(pos), raw_.begin() + std::ptrdiff_t(pos + len));
+        }
+        endChunk(out, start);
+    }
+    void end(std::vector<uint8_t>& out) override {
+        size_t start = beginChunk(out, "IDAT");
+        if (zlib_header_) {
+            out.push_back(0x78);
+            out.push_back(0x01);
+        }
+        const uint8_t last[5] = {1, 0, 0, 0xFF, 0xFF}; // BFINAL, stored, LEN 0
+        out.insert(out.end(), last, last + 5);
+        uint8_t sum[4];
+        putBE32(sum, adler_b_ << 16 | adler_a_);
+        out.insert(out.end(), sum, sum + 4);
+        endChunk(out, start);
+        chunk(out, "IEND", nullptr, 0);
+    }
+
+    // CRC-32 as used by PNG and zlib, eight bytes per step (slicing-by-8).
+    static uint32_t crc32(uint32_t crc, const uint8_t* p, size_t n) {
+        static const std::vector<uint32_t> table = makeCrcTable();
+        const uint32_t* t = table.data();
+        crc = ~crc;
+        for (; n >= 8; n -= 8, p += 8) {
+            uint32_t lo = crc ^ (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24);
+            uint32_t hi = uint32_t(p[4]) | uint32_t(p[5]) << 8 | uint32_t(p[6]) << 16 | uint32_t(p[7]) << 24;
+            crc = t[1792 + (lo & 0xFF)] ^ t[1536 + ((lo >> 8) & 0xFF)] ^ t[1280 + ((lo >> 16) & 0xFF)] ^ t[1024 + (lo >> 24)]
+                ^ t[768 + (hi & 0xFF)] ^ t[512 + ((hi >> 8) & 0xFF)] ^ t[256 + ((hi >> 16) & 0xFF)] ^ t[hi >> 24];
+        }
+        for (; n > 0; --n, ++p) {
+            crc = t[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+private:
+    static std::vector<uint32_t> makeCrcTable() {
+        std::vector<uint32_t> t(2048);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        for (int s = 1; s < 8; ++s) {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = t[(s - 1) * 256 + i];
+                t[s * 256 + i] = t[c & 0xFF] ^ (c >> 8);
+            }
+        }
+        return t;
+    }
+    // Adler-32, reducing modulo 65521 only every 5552 bytes, the most that cannot overflow.
+    void adler(const uint8_t* p, size_t n) {
+        while (n > 0) {
+            size_t k = std::min<size_t>(n, 5552);
+            n -= k;
+            // 16 bytes at a time: b grows by 16 * a plus each byte weighted by how many sums it enters
+            for (; k >= 16; k -= 16, p += 16) {
+                uint32_t sum = 0;
+                uint32_t weighted = 0;
+                for (int i = 0; i < 16; ++i) {
+                    sum += p[i];
+                    weighted += uint32_t(16 - i) * p[i];
+                }
+                adler_b_ += 16 * adler_a_ + weighted;
+                adler_a_ += sum;
+            }
+            for (; k > 0; --k) {
+                adler_a_ += *p++;
+                adler_b_ += adler_a_;
+            }
+            adler_a_ %= 65521;
+            adler_b_ %= 65521;
+        }
+    }
+    static void putBE32(uint8_t* p, uint32_t v) {
+        p[0] = uint8_t(v >> 24);
+        p[1] = uint8_t(v >> 16);
+        p[2] = uint8_t(v >> 8);
+        p[3] = uint8_t(v);
+    }
+    // Writes a length placeholder and the type; returns where the chunk starts.
+    static size_t beginChunk(std::vector<uint8_t>& out, const char* type) {
+        size_t start = out.size();
+        out.resize(start + 4);
+        out.insert(out.end(), type, type + 4);
+        return start;
+    }
+    static void endChunk(std::vector<uint8_t>& out, size_t start) {
+        uint32_t length = uint32_t(out.size() - start - 8);
+        putBE32(out.data() + start, length);
+        uint8_t crc[4];
+        putBE32(crc, crc32(0, out.data() + start + 4, length + 4));
+        out.insert(out.end(), crc, crc + 4);
+    }
+    static void chunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t n) {
+        size_t start = beginChunk(out, type);
+        if (n > 0) {
+            out.insert(out.end(), data, data + n);
+        }
+        endChunk(out, start);
+    }
+
+    std::vector<uint8_t> raw_;
+    uint32_t adler_a_ = 1;
+    uint32_t adler_b_ = 0;
+    bool zlib_header_ = true;
+};
+
+// BMP from a whole image in memory (rows bottom-up, as the generators fill them). Streaming BMP
+// output is BMPStreamWriter; this is the in-memory counterpart for comparing formats.
+inline void encodeBMP(const ImageView& image, std::vector<uint8_t>& out) {
+    BMPFileHeader file_header;
+    BMPInfoHeader info_header;
+    makeBMPHeaders(image.width, int(image.rows), file_header, info_header);
+    out.insert(out.end(), (const uint8_t*)&file_header, (const uint8_t*)&file_header + sizeof(file_header));
+    out.insert(out.end(), (const uint8_t*)&info_header, (const uint8_t*)&info_header + sizeof(info_header));
+    size_t n = size_t(image.width) * 3;
+    size_t stride = bmpStride(image.width);
+    size_t pos = out.size();
+    out.resize(pos + stride * image.rows, 0);
+    for (size_t y = 0; y < image.rows; ++y) {
+        // row(y) is top-down; BMP stores the bottom row first
+        std::memcpy(out.data() + pos + (image.rows - 1 - y) * stride, image.row(y), n);
+    }
+}
+
+// "ppm", "qoi" or "png"; nullptr for anything else.
+inline std::unique_ptr<ImageEncoder> makeEncoder(const std::string& format) {
+    if (format == "ppm") {
+        return std::unique_ptr<ImageEncoder>(new PPMEncoder);
+    }
+    if (format == "qoi") {
+        return std::unique_ptr<ImageEncoder>(new QOIEncoder);
+    }
+    if (format == "png") {
+        return std::unique_ptr<ImageEncoder>(new PNGEncoder);
+    }
+    return nullptr;
+}
+
+#endif // IMAGE_ENCODERS_H
@@ -0,0 +1,27 @@
+#ifndef PARALLEL_ROWS_H
+#define PARALLEL_ROWS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Splits rows [0, rows) into one contiguous band per thread and calls band(begin, end) on each,
+// the first band on the calling thread.
+template <class Band>
+void parallelRows(size_t rows, unsigned threads, Band band) {
+    if (threads == 0) {
+        threads = 1;
+    }
+    std::vector<std::thread> pool;
+    size_t per = (rows + threads - 1) / threads;
+    for (unsigned t = 1; t < threads && t * per < rows; ++t) {
+        pool.emplace_back(band, t * per, std::min(rows, (t + 1) * per));
+    }
+    band(size_t(0), std::min(rows, per));
+    for (std::thread& th: pool) {
+        th.join();
+    }
+}
+
+#endif // PARALLEL_ROWS_H
@@ -0,0 +1,55 @@
+#ifndef PATTERNS_H
+#define PATTERNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "hsv_batch.h"
+#include "parallel_rows.h"
+#include "philox.h"
+
+enum class Pattern { Noise, HSVGradient, HSVNoise };
+
+// One HSV row at a time: fill structure-of-arrays h, s, v, then convert the whole row with hsv2rgbBatch.
+// Gradient: hue runs 0..360 across, saturation rises from the bottom row to the top.
+// HSV noise: 4 Philox bytes per pixel, 2 for hue and 1 each for saturation and value.
+inline void fillHSV(Pattern pattern, uint8_t* data, int width, size_t stride, size_t rows,
+                    uint64_t first_row, int height, uint64_t seed, unsigned threads) {
+    Philox4x32::Key key = Philox4x32::SeedKey(seed);
+    parallelRows(rows, threads, [&](size_t begin, size_t end) {
+        std::vector<float> h(width), s(width), v(width);
+        std::vector<uint8_t> bits(pattern == Pattern::HSVNoise ? size_t(width) * 4 : 0);
+        for (size_t y = begin; y < end; ++y) {
+            uint64_t row = first_row + y;
+            if (pattern == Pattern::HSVGradient) {
+                float sat = height > 1 ? float(row) / float(height - 1) : 1.0f;
+                for (int x = 0; x < width; ++x) {
+                    h[x] = float(x) * 360.0f / float(width);
+                    s[x] = sat;
+                    v[x] = 1.0f;
+                }
+            } else {
+                fillNoiseRow(bits.data(), bits.size(), row, key);
+                for (int x = 0; x < width; ++x) {
+                    const uint8_t* b = &bits[size_t(x) * 4];
+                    h[x] = float(b[0] | (b[1] << 8)) * (360.0f / 65536.0f);
+                    s[x] = float(b[2]) * (1.0f / 255.0f);
+                    v[x] = float(b[3]) * (1.0f / 255.0f);
+                }
+            }
+            hsv2rgbBatch(h.data(), s.data(), v.data(), size_t(width), data + y * stride);
+        }
+    });
+}
+
+// Fills `rows` padded rows starting at image row first_row.
+inline void fillRows(Pattern pattern, uint8_t* data, int width, size_t stride, size_t rows,
+                     uint64_t first_row, int height, uint64_t seed, unsigned threads) {
+    if (pattern == Pattern::Noise) {
+        fillNoise(data, size_t(width) * 3, stride, rows, seed, threads, first_row);
+    } else {
+        fillHSV(pattern, data, width, stride, rows, first_row, height, seed, threads);
+    }
+}
+
+#endif // PATTERNS_H
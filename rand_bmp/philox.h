@@ -0,0 +1,95 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "parallel_rows.h"
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// A counter-based generator: the output is a pure function of (counter, key), so any
+// block of the stream can be computed directly without generating everything before it.
+class Philox4x32 {
+public:
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    static Counter Block(Counter c, Key k) {
+        for(int round = 0; round < 10; ++round) {
+            uint64_t p0 = uint64_t(0xD2511F53) * c[0];
+            uint64_t p1 = uint64_t(0xCD9E8D57) * c[2];
+            c = {uint32_t(p1 >> 32) ^ c[1] ^ k[0], uint32_t(p1),
+                 uint32_t(p0 >> 32) ^ c[3] ^ k[1], uint32_t(p0)};
+            k[0] += 0x9E3779B9;
+            k[1] += 0xBB67AE85;
+        }
+        return c;
+    }
+
+    static Key SeedKey(uint64_t seed) {
+        return {uint32_t(seed), uint32_t(seed >> 32)};
+    }
+};
+
+// Fills bytes [0, n) of row y with noise. Block b of a row is Philox(counter = {b, y, 0, 0}),
+// so a row's bytes depend only on the seed and y, never on which thread produced them.
+inline void fillNoiseRow(uint8_t* row, size_t n, uint64_t y, Philox4x32::Key key) {
+    size_t blocks = n / 16;
+    size_t b = 0;
+    // 8 blocks side by side in structure-of-arrays form so the compiler can keep the
+    // lanes in vector registers; same numbers as calling Block() 8 times.
+    const int LANES = 8;
+    for(; b + LANES <= blocks; b += LANES) {
+        uint32_t c0[LANES], c1[LANES], c2[LANES], c3[LANES];
+        for(int l = 0; l < LANES; ++l) {
+            c0[l] = uint32_t(b + l);
+            c1[l] = uint32_t(y);
+            c2[l] = uint32_t(y >> 32);
+            c3[l] = 0;
+        }
+        uint32_t k0 = key[0], k1 = key[1];
+        for(int round = 0; round < 10; ++round) {
+            for(int l = 0; l < LANES; ++l) {
+                uint64_t p0 = uint64_t(0xD2511F53) * c0[l];
+                uint64_t p1 = uint64_t(0xCD9E8D57) * c2[l];
+                uint32_t n0 = uint32_t(p1 >> 32) ^ c1[l] ^ k0;
+                uint32_t n2 = uint32_t(p0 >> 32) ^ c3[l] ^ k1;
+                c1[l] = uint32_t(p1);
+                c3[l] = uint32_t(p0);
+                c0[l] = n0;
+                c2[l] = n2;
+            }
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        for(int l = 0; l < LANES; ++l) {
+            uint32_t out[4] = {c0[l], c1[l], c2[l], c3[l]};
+            std::memcpy(row + (b + l) * 16, out, 16);
+        }
+    }
+    for(; b < blocks; ++b) {
+        Philox4x32::Counter r = Philox4x32::Block({uint32_t(b), uint32_t(y), uint32_t(y >> 32), 0}, key);
+        std::memcpy(row + b * 16, r.data(), 16);
+    }
+    if(n % 16) {
+        Philox4x32::Counter r = Philox4x32::Block({uint32_t(blocks), uint32_t(y), uint32_t(y >> 32), 0}, key);
+        std::memcpy(row + blocks * 16, r.data(), n % 16);
+    }
+}
+
+// Fills `height` rows of an image whose rows are row_bytes long and stride apart; data points
+// at image row first_row. Each thread takes a contiguous band of rows; the result is identical
+// for any thread count and any split of the image into calls.
+inline void fillNoise(uint8_t* data, size_t row_bytes, size_t stride, size_t height,
+                      uint64_t seed, unsigned threads, uint64_t first_row = 0) {
+    Philox4x32::Key key = Philox4x32::SeedKey(seed);
+    parallelRows(height, threads, [&](size_t begin, size_t end) {
+        for(size_t y = begin; y < end; ++y) {
+            fillNoiseRow(data + y * stride, row_bytes, first_row + y, key);
+        }
+    });
+}
+
+#endif // PHILOX_H
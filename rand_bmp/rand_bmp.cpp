@@ -5,31 +5,14 @@
 #include <ctime>
 #include <random>
 #include <algorithm>
-
-#pragma pack(push, 1)
-
-struct BMPFileHeader {
-    uint16_t file_type{0x4D42};
-    uint32_t file_size{0};
-    uint16_t reserved1{0};
-    uint16_t reserved2{0};
-    uint32_t offset_data{0};
-};
-
-struct BMPInfoHeader {
-    uint32_t size{0};
-    int32_t width{0};
-    int32_t height{0};
-    uint16_t planes{1};
-    uint16_t bit_count{0};
-    uint32_t compression{0};
-    uint32_t size_image{0};
-    int32_t x_pixels_per_meter{0};
-    int32_t y_pixels_per_meter{0};
-    uint32_t colors_used{0};
-    uint32_t colors_important{0};
-};
-#pragma pack(pop)
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "patterns.h"
+#include "bmp_writer.h"
+#include "image_encoders.h"
+#include "bmp_mmap.h"
+#include "bmp_pipeline.h"
 
 typedef struct {
     double r;       // a fraction between 0 and 1
@@ -100,56 +83,216 @@ rgb hsv2rgb(hsv in) {
     return out;
 }
 
-void generateBMPImage(int width, int height) {
-    BMPFileHeader file_header;
-    BMPInfoHeader info_header;
-
-    info_header.size = sizeof(BMPInfoHeader);
-    info_header.width = width;
-    info_header.height = height;
-    info_header.bit_count = 24;
+// Random noise and HSV noise come from Philox keyed by seed, one row band per thread: the same seed gives
+// the same image whatever the thread count. Rows are generated a chunk at a time and
+// streamed to disk while the next chunk is generated, so memory use does not grow with the image.
+// With use_mmap the file is mapped instead and every thread writes its rows straight into the mapping.
+// Returns the exit status: 0, or 1 if the file could not be written.
+int generateBMPImage(int width, int height, Pattern pattern, uint64_t seed, unsigned threads, bool use_mmap) {
+    const size_t row_bytes = size_t(width) * 3;
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok;
+    if (use_mmap) {
+        BMPMappedFile file;
+        ok = file.open("random.bmp", width, height);
+        if (ok) {
+            fillRows(pattern, file.row(0), width, file.stride(), size_t(height), 0, height, seed, threads);
+        }
+    } else {
+        BMPStreamWriter writer("random.bmp", width, height);
+        while (BMPStreamWriter::Chunk* c = writer.nextChunk()) {
+            fillRows(pattern, c->data.data(), width, c->stride, c->rows, c->first_row, height, seed, threads);
+            writer.submit(c);
+        }
+        ok = writer.finish();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "seed " << seed << ", " << threads << " threads, "
+              << row_bytes * height / seconds / 1e6 << " MB/s" << std::endl;
 
-    const int padding_amount = ((4 - (width * 3) % 4) % 4);
+    if (!ok) {
+        std::cerr << "Unable to write file." << std::endl;
+        return 1;
+    }
+    std::cout << "BMP image created." << std::endl;
+    return 0;
+}
 
-    file_header.offset_data = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader);
-    file_header.file_size = file_header.offset_data + (width * 3 + padding_amount) * height;
+// PPM, QOI and PNG are stored top row first, so rows are generated from the top of the image
+// down, a chunk at a time, and each chunk's encoded bytes are written before the next is generated.
+// Returns the exit status: 0, 1 if the file could not be written, or 2 for an unknown format.
+int generateImage(int width, int height, Pattern pattern, uint64_t seed, unsigned threads,
+                  const std::string& format) {
+    // look the encoder up first, so an unknown format does not leave an empty file behind
+    std::unique_ptr<ImageEncoder> encoder = makeEncoder(format);
+    if (!encoder) {
+        std::cerr << "unknown format " << format << std::endl;
+        return 2;
+    }
+    std::string path = "random." + format;
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    if (!file) {
+        std::cerr << "Unable to open " << path << std::endl;
+        return 1;
+    }
+    const size_t row_bytes = size_t(width) * 3;
+    const size_t chunk_rows = std::max<size_t>(1, (size_t(4) << 20) / row_bytes);
+    std::vector<uint8_t> pixels(chunk_rows * row_bytes);
+    std::vector<uint8_t> out;
 
-    std::vector<uint8_t> img_data(width * height * 3);
+    auto t0 = std::chrono::steady_clock::now();
+    encoder->begin(width, height, out);
+    for (size_t top = 0; top < size_t(height); top += chunk_rows) {
+        size_t rows = std::min(chunk_rows, size_t(height) - top);
+        size_t first_row = size_t(height) - top - rows; // in BMP (bottom-up) row numbers
+        fillRows(pattern, pixels.data(), width, row_bytes, rows, first_row, height, seed, threads);
+        ImageView view;
+        view.data = pixels.data();
+        view.width = width;
+        view.rows = rows;
+        view.stride = row_bytes;
+        view.bottom_up = true;
+        encoder->addRows(view, out);
+        file.write((const char*)out.data(), std::streamsize(out.size()));
+        out.clear();
+    }
+    encoder->end(out);
+    file.write((const char*)out.data(), std::streamsize(out.size()));
+    file.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "seed " << seed << ", " << threads << " threads, "
+              << row_bytes * height / seconds / 1e6 << " MB/s" << std::endl;
+    if (!file) {
+        std::cerr << "Unable to write file." << std::endl;
+        return 1;
+    }
+    std::cout << format << " image created." << std::endl;
+    return 0;
+}
 
-    //srand((unsigned)time(0));
-    std::random_device r;
-    std::mt19937 e1(r());
-    std::uniform_int_distribution<int> dist(0, 255);
-    /*for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            img_data[(y * width + x) * 3 + 0] = dist(e1); // Blue
-            img_data[(y * width + x) * 3 + 1] = dist(e1); // Green
-            img_data[(y * width + x) * 3 + 2] = dist(e1); // Red
+// Converts n random pixels with hsv2rgb one at a time, then with the batch kernel (plain C++ and the
+// vectorized build), and prints Mpixel/s for each plus the largest difference from hsv2rgb.
+void benchHSV(size_t n) {
+    std::vector<float> h(n), s(n), v(n);
+    std::mt19937 e1(1);
+    std::uniform_real_distribution<float> hue(0.0f, 360.0f), unit(0.0f, 1.0f);
+    for (size_t i = 0; i < n; ++i) {
+        h[i] = hue(e1);
+        s[i] = unit(e1);
+        v[i] = unit(e1);
+    }
+    std::vector<uint8_t> expected(n * 3), out(n * 3);
+    auto run = [&](const char* name, std::vector<uint8_t>& dst, auto convert) {
+        auto t0 = std::chrono::steady_clock::now();
+        const int reps = 10;
+        for (int r = 0; r < reps; ++r) {
+            convert(dst.data());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        int diff = 0;
+        for (size_t i = 0; i < n * 3; ++i) {
+            diff = std::max(diff, std::abs(int(dst[i]) - int(expected[i])));
         }
-    }*/
-    std::generate(img_data.begin(), img_data.end(), 
-        [&dist, &e1]() { return dist(e1); });
+        std::cout << name << ": " << n * reps / seconds / 1e6 << " Mpixel/s, max diff " << diff << std::endl;
+    };
+    run("hsv2rgb", expected, [&](uint8_t* bgr) {
+        for (size_t i = 0; i < n; ++i) {
+            rgb c = hsv2rgb(hsv{h[i], s[i], v[i]});
+            bgr[i * 3 + 0] = uint8_t(int(c.b * 255.0 + 0.5));
+            bgr[i * 3 + 1] = uint8_t(int(c.g * 255.0 + 0.5));
+            bgr[i * 3 + 2] = uint8_t(int(c.r * 255.0 + 0.5));
+        }
+    });
+    run("batch scalar", out, [&](uint8_t* bgr) { hsv2rgbBatchScalar(h.data(), s.data(), v.data(), n, bgr); });
+    run("batch simd", out, [&](uint8_t* bgr) { hsv2rgbBatch(h.data(), s.data(), v.data(), n, bgr); });
+}
 
-    std::ofstream file("random.bmp", std::ios::out | std::ios::binary);
-    if (file) {
-        file.write((const char *)&file_header, sizeof(file_header));
-        file.write((const char *)&info_header, sizeof(info_header));
-        file.write((const char *)img_data.data(), img_data.size());
-        file.close();
-        std::cout << "BMP image created." << std::endl;
-    } else {
-        std::cerr << "Unable to open file." << std::endl;
+// Reads `in`, runs the comma separated kernels (gray, invert, blur, threshold=N, resize=WxH) and writes `out`.
+int transformBMP(const char* in, const char* out, const std::string& kernels, unsigned threads) {
+    BMPPipeline pipeline;
+    for (size_t pos = 0; pos <= kernels.size();) {
+        size_t end = std::min(kernels.find(',', pos), kernels.size());
+        std::unique_ptr<Kernel> k = makeKernel(kernels.substr(pos, end - pos));
+        if (!k) {
+            std::cerr << "bad kernel " << kernels.substr(pos, end - pos) << std::endl;
+            return 2;
+        }
+        if (!pipeline.add(std::move(k))) {
+            std::cerr << "resize must be the last kernel" << std::endl;
+            return 2;
+        }
+        pos = end + 1;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    std::string error;
+    if (!pipeline.run(in, out, threads, 64, &error)) {
+        std::cerr << error << std::endl;
+        return 1;
     }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    BMPStreamReader reader;
+    reader.open(in);
+    std::cout << threads << " threads, " << size_t(reader.width()) * 3 * reader.height() / seconds / 1e6
+              << " MB/s" << std::endl;
+    return 0;
 }
 
-int main() {
+// rand_bmp [-j threads] [-s seed] [-m noise|gradient|hsv-noise] [-o stream|mmap] [-f bmp|ppm|qoi|png] [width height]
+// rand_bmp -b [pixels]   benchmark hsv2rgb against the batch kernel
+// rand_bmp [-j threads] -p in.bmp out.bmp gray,blur,threshold=128,resize=640x480
+int main(int argc, char* argv[]) {
     /*int width, height;
     std::cout << "Enter width: ";
     std::cin >> width;
     std::cout << "Enter height: ";
     std::cin >> height;*/
 
-    generateBMPImage(1000, 1000);
+    int width = 1000;
+    int height = 1000;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = std::random_device{}();
+    Pattern pattern = Pattern::Noise;
+    bool bench = false;
+    bool use_mmap = false;
+    std::string format = "bmp";
+    std::vector<int> size;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 < argc && strcmp(argv[i], "-j") == 0) {
+            threads = unsigned(atoi(argv[++i]));
+        } else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+            ++i;
+            pattern = strcmp(argv[i], "gradient") == 0 ? Pattern::HSVGradient
+                    : strcmp(argv[i], "hsv-noise") == 0 ? Pattern::HSVNoise : Pattern::Noise;
+        } else if (i + 1 < argc && strcmp(argv[i], "-f") == 0) {
+            format = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+            use_mmap = strcmp(argv[++i], "mmap") == 0;
+        } else if (i + 3 < argc && strcmp(argv[i], "-p") == 0) {
+            return transformBMP(argv[i + 1], argv[i + 2], argv[i + 3], threads);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            bench = true;
+        } else {
+            size.push_back(atoi(argv[i]));
+        }
+    }
+    if (bench) {
+        benchHSV(size.empty() ? size_t(1) << 20 : size_t(size[0]));
+        return 0;
+    }
+    if (size.size() >= 2) {
+        width = size[0];
+        height = size[1];
+    }
+    if (width <= 0 || height <= 0) {
+        std::cerr << "usage: rand_bmp [-j threads] [-s seed] [-m noise|gradient|hsv-noise] [-o stream|mmap]"
+                     " [-f bmp|ppm|qoi|png] [width height], width and height > 0" << std::endl;
+        return 2;
+    }
 
-    return 0;
+    if (format == "bmp") {
+        return generateBMPImage(width, height, pattern, seed, threads, use_mmap);
+    }
+    return generateImage(width, height, pattern, seed, threads, format);
 }
@@ -3,6 +3,7 @@
 #include <print>
 #include <iostream>
 #include <vector>
+#include "split-view.h"
 
 using std::string;
 using namespace std;
@@ -19,4 +20,9 @@ int main() {
         cout<<s<<"\n";
     }
 
+    // the same words as string_views into str, no string per token
+    for(std::string_view s: SplitView(str, " ")) {
+        cout<<s<<"\n";
+    }
+
 }
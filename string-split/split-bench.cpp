@@ -0,0 +1,110 @@
+// Split throughput in GB/s on generated log lines, for 2, 4 and 8 delimiters:
+// split() (find_first_of, a string per token), SplitView, the scalar bitmask loop and splitSimd.
+// Then the same text as a file through tokenizeFile with 1, 2, 4, ... threads up to the core count.
+//
+//   g++ -std=c++20 -O2 -march=native -pthread split-bench.cpp -o split-bench && ./split-bench [megabytes]
+//   (-mavx2 or -msse4.2 instead of -march=native pick one vector path, neither gives the table path)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "vector-string.cpp"
+#include "split-view.h"
+#include "split-simd.h"
+#include "split-file.h"
+
+// Lines like "2024-05-01T12:00:00 INFO  worker-3 request=1234, bytes=567; took 89us\n"
+static string makeLog(size_t bytes)
+{
+    std::mt19937 rng(1);
+    const char* levels[] = {"INFO", "WARN", "DEBUG", "ERROR"};
+    string text;
+    text.reserve(bytes + 128);
+    char line[128];
+    while (text.size() < bytes) {
+        int n = snprintf(line, sizeof(line), "2024-05-01T12:%02u:%02u %s\tworker-%u request=%u, bytes=%u; took %uus\n",
+                         unsigned(rng() % 60), unsigned(rng() % 60), levels[rng() % 4], unsigned(rng() % 16),
+                         unsigned(rng() % 100000), unsigned(rng() % 10000), unsigned(rng() % 1000));
+        text.append(line, size_t(n));
+    }
+    return text;
+}
+
+template <class Split>
+static void run(const char* name, const string& text, Split&& split)
+{
+    size_t tokens = 0;
+    size_t checksum = 0;
+    double best = 1e30;
+    for (int rep = 0; rep < 3; ++rep) {
+        tokens = 0;
+        checksum = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        split([&](std::string_view token) {
+            ++tokens;
+            checksum += token.size();
+        });
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+    printf("  %-12s %6.2f GB/s  %zu tokens, %zu token bytes\n", name, text.size() / best / 1e9, tokens, checksum);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t megabytes = argc > 1 ? size_t(atoi(argv[1])) : 256;
+    string text = makeLog(megabytes << 20);
+#if defined(__AVX2__)
+    const char* path = "avx2";
+#elif defined(__SSE4_2__)
+    const char* path = "sse4.2";
+#else
+    const char* path = "scalar";
+#endif
+    printf("%zu MB, vector path %s\n", text.size() >> 20, path);
+    for (string delimiters : {string(" \n"), string(" \n\t="), string(" \n\t=,;:-")}) {
+        printf("%zu delimiters\n", delimiters.size());
+        run("split", text, [&](auto&& fn) {
+            for (const string& token : split(text, delimiters)) {
+                fn(token);
+            }
+        });
+        run("SplitView", text, [&](auto&& fn) {
+            for (std::string_view token : SplitView(text, delimiters)) {
+                fn(token);
+            }
+        });
+        run("splitScalar", text, [&](auto&& fn) { splitScalar(text, delimiters, fn); });
+        run("splitSimd", text, [&](auto&& fn) { splitSimd(text, delimiters, fn); });
+    }
+
+    // the file stays in the page cache, so this measures tokenizing, not the disk
+    const char* file = "split-bench.tmp";
+    FILE* f = fopen(file, "wb");
+    if (!f || fwrite(text.data(), 1, text.size(), f) != text.size()) {
+        printf("cannot write %s\n", file);
+        return 1;
+    }
+    fclose(f);
+    const string delimiters = " \n\t=";
+    printf("tokenizeFile, %zu delimiters\n", delimiters.size());
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1;; threads = std::min(threads * 2, cores)) {
+        FileTokens tokens;
+        double best = 1e30;
+        for (int rep = 0; rep < 3; ++rep) {
+            auto t0 = std::chrono::steady_clock::now();
+            tokenizeFile(file, delimiters, threads, tokens);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+        }
+        printf("  %2u threads   %6.2f GB/s  %zu tokens\n", threads, text.size() / best / 1e9, tokens.size());
+        if (threads == cores) {
+            break;
+        }
+    }
+    remove(file);
+}
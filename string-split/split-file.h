@@ -0,0 +1,185 @@
+#pragma once
+// Tokenizes a whole file in parallel without copying it.
+//   - the file is mapped read-only; tokens are (offset, length) pairs into the mapping
+//   - the mapping is cut into one chunk per thread, and each cut is moved forward to the next
+//     delimiter so no token straddles two chunks
+//   - each thread first counts the tokens of its chunk with splitSimd; the counts give every chunk
+//     its slice of one result array, and a second splitSimd pass writes the tokens straight into
+//     that slice, so they come out in file order with no per-thread arrays to grow or copy
+//
+//   FileTokens tokens;
+//   std::string error;
+//   if (!tokenizeFile("big.log", " \t\n", std::thread::hardware_concurrency(), tokens, &error)) ...
+//   for (size_t i = 0; i < tokens.size(); ++i) use(tokens.token(i));
+//
+// POSIX only; tokenizeFile() fails where mmap is not available.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "split-simd.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SPLIT_HAVE_MMAP 1
+#endif
+
+struct FileToken {
+    uint64_t offset; // from the start of the file
+    uint64_t length;
+};
+
+// A file mapped read-only for its whole size.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() {
+        close();
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string* error = nullptr) {
+        close();
+#ifdef SPLIT_HAVE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return fail(error, "cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return fail(error, "cannot stat " + path);
+        }
+        size_ = size_t(st.st_size);
+        if (size_ > 0) { // mmap rejects a zero length; an empty file has no tokens anyway
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                size_ = 0;
+                return fail(error, "cannot map " + path);
+            }
+            data_ = static_cast<const char*>(p);
+        }
+        ::close(fd); // the mapping keeps the file alive
+        return true;
+#else
+        return fail(error, "mmap is not available");
+#endif
+    }
+
+    void close() {
+#ifdef SPLIT_HAVE_MMAP
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    std::string_view view() const { return std::string_view(data_, size_); }
+private:
+    static bool fail(std::string* error, const std::string& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// The tokens of a file, valid as long as this object (which owns the mapping) lives.
+class FileTokens {
+public:
+    size_t size() const { return size_; }
+    const FileToken& operator[](size_t i) const { return tokens_[i]; }
+    const FileToken* begin() const { return tokens_.get(); }
+    const FileToken* end() const { return tokens_.get() + size_; }
+    std::string_view token(size_t i) const { return file_.view().substr(tokens_[i].offset, tokens_[i].length); }
+    std::string_view text() const { return file_.view(); }
+private:
+    friend bool tokenizeFile(const std::string&, std::string_view, unsigned, FileTokens&, std::string*);
+
+    MappedFile file_;
+    std::unique_ptr<FileToken[]> tokens_; // not zeroed first: every element is written once
+    size_t size_ = 0;
+};
+
+// Splits the file at path on any of the delimiter characters, with the same tokens as
+// splitSimd(whole file, delimiters), using up to `threads` threads (0 means one per core).
+// Returns false with a message in *error if the file cannot be mapped.
+inline bool tokenizeFile(const std::string& path, std::string_view delimiters, unsigned threads,
+                         FileTokens& out, std::string* error = nullptr)
+{
+    out.tokens_.reset();
+    out.size_ = 0;
+    if (!out.file_.open(path, error)) {
+        return false;
+    }
+    const std::string_view text = out.file_.view();
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // below 1 MB per thread the thread start-up costs more than the split
+    threads = unsigned(std::max<size_t>(1, std::min<size_t>(threads, text.size() >> 20)));
+
+    // chunk k is [cuts[k], cuts[k + 1]); every inner cut sits on a delimiter (or the end of the file)
+    DelimiterSet table(delimiters);
+    std::vector<size_t> cuts(threads + 1, text.size());
+    cuts[0] = 0;
+    for (unsigned k = 1; k < threads; ++k) {
+        size_t cut = std::max(cuts[k - 1], text.size() / threads * k);
+        while (cut < text.size() && !table.contains(text[cut])) {
+            ++cut;
+        }
+        cuts[k] = cut;
+    }
+
+    const SimdDelimiters set(delimiters);
+    std::vector<size_t> first(threads + 1, 0); // index of chunk k's first token in the result
+    auto chunk = [&](unsigned k) { return text.substr(cuts[k], cuts[k + 1] - cuts[k]); };
+    auto parallel = [threads](auto&& fn) {
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for (unsigned k = 1; k < threads; ++k) {
+            pool.emplace_back(fn, k);
+        }
+        fn(0u);
+        for (std::thread& t : pool) {
+            t.join();
+        }
+    };
+
+    // pass 1: count each chunk's tokens
+    parallel([&](unsigned k) {
+        size_t count = 0;
+        splitSimd(chunk(k), set, [&](std::string_view) { ++count; });
+        first[k + 1] = count;
+    });
+    for (unsigned k = 0; k < threads; ++k) {
+        first[k + 1] += first[k];
+    }
+
+    // pass 2: each chunk fills its own slice of the result
+    out.size_ = first[threads];
+    out.tokens_.reset(new FileToken[out.size_]);
+    parallel([&](unsigned k) {
+        FileToken* slot = out.tokens_.get() + first[k];
+        splitSimd(chunk(k), set, [&](std::string_view token) {
+            *slot++ = FileToken{uint64_t(token.data() - text.data()), uint64_t(token.size())};
+        });
+    });
+    return true;
+}
@@ -0,0 +1,108 @@
+#pragma once
+// Lazy split into std::string_view tokens, with the same rules as split() in vector-string.cpp:
+// any character of `delimiters` separates tokens, runs of delimiters count as one and empty tokens
+// are skipped. Nothing is copied or allocated; the tokens point into the original string, which
+// must outlive them.
+//
+//   for (std::string_view word : SplitView(line, " \t,")) ...
+//
+//   std::vector<std::string_view> tokens;
+//   while (read(line)) {
+//       split(line, " \t,", tokens); // reuses tokens' storage, no allocation once it is big enough
+//   }
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+// Membership of a byte in the delimiter set, one bit per byte value: a constant time test instead
+// of the scan over the delimiters that find_first_of does for every character.
+class DelimiterSet {
+public:
+    explicit DelimiterSet(std::string_view delimiters) {
+        for (unsigned char c : delimiters) {
+            bits_[c >> 6] |= uint64_t(1) << (c & 63);
+        }
+    }
+    bool contains(char ch) const {
+        unsigned char c = static_cast<unsigned char>(ch);
+        return (bits_[c >> 6] >> (c & 63)) & 1;
+    }
+private:
+    uint64_t bits_[4] = {};
+};
+
+class SplitView {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string_view;
+
+        iterator() = default;
+
+        std::string_view operator*() const { return std::string_view(begin_, std::size_t(end_ - begin_)); }
+
+        iterator& operator++() {
+            begin_ = skipDelimiters(end_);
+            end_ = tokenEnd(begin_);
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const iterator& other) const { return begin_ == other.begin_; }
+        bool operator!=(const iterator& other) const { return begin_ != other.begin_; }
+    private:
+        friend class SplitView;
+
+        iterator(const SplitView* view, const char* from): view_(view) {
+            begin_ = skipDelimiters(from);
+            end_ = tokenEnd(begin_);
+        }
+        const char* skipDelimiters(const char* p) const {
+            while (p != view_->last_ && view_->delimiters_.contains(*p)) {
+                ++p;
+            }
+            return p;
+        }
+        const char* tokenEnd(const char* p) const {
+            while (p != view_->last_ && !view_->delimiters_.contains(*p)) {
+                ++p;
+            }
+            return p;
+        }
+
+        const SplitView* view_ = nullptr;
+        const char* begin_ = nullptr; // current token, begin_ == end_ == last_ at the end
+        const char* end_ = nullptr;
+    };
+
+    explicit SplitView(std::string_view s, std::string_view delimiters = " ")
+        : first_(s.data()), last_(s.data() + s.size()), delimiters_(delimiters) {}
+
+    iterator begin() const { return iterator(this, first_); }
+    iterator end() const { return iterator(this, last_); }
+private:
+    const char* first_;
+    const char* last_;
+    DelimiterSet delimiters_;
+};
+
+// The tokens of s, stored in `tokens` (cleared first). Reusing the same vector for every call
+// allocates nothing once it has held as many tokens as the longest input.
+inline void split(std::string_view s, std::string_view delimiters, std::vector<std::string_view>& tokens)
+{
+    tokens.clear();
+    for (std::string_view token : SplitView(s, delimiters)) {
+        tokens.push_back(token);
+    }
+}
@@ -0,0 +1,206 @@
+#ifndef HEURISTIC_SEARCH_H
+#define HEURISTIC_SEARCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include <vector>
+#include "jug_solver.h"
+
+// 比单向BFS扩展更少状态的两种搜索：
+// BidirectionalSolve要求目标状态完全确定，从起点正向、从终点用反向倒水同时搜，在中间相遇；
+// AStarSolve适用于任意目标，需要一个可采纳（不高估剩余步数）且一致的启发函数。
+
+// 目标是某个桶里有amount升水时的启发函数：
+// 已经满足是0；一次倒水能满足是1；否则至少要2步。
+struct ContainsHeuristic {
+    int amount;
+
+    int operator()(const JugPuzzle& puzzle, uint64_t code) const {
+        const int n = puzzle.Buckets();
+        for(int i = 0; i < n; ++i) {
+            if(puzzle.Amount(code, i) == amount) {
+                return 0;
+            }
+        }
+        for(int i = 0; i < n; ++i) {
+            for(int j = 0; j < n; ++j) {
+                if(puzzle.CanPour(code, i, j)) {
+                    uint64_t next = puzzle.Pour(code, i, j);
+                    if(puzzle.Amount(next, i) == amount || puzzle.Amount(next, j) == amount) {
+                        return 1;
+                    }
+                }
+            }
+        }
+        return 2;
+    }
+};
+
+// 目标状态完全确定时的启发函数：一次倒水最多改变两个桶，所以至少要(不同的桶数+1)/2步。
+struct ExactStateHeuristic {
+    uint64_t code;
+
+    int operator()(const JugPuzzle& puzzle, uint64_t c) const {
+        int diff = 0;
+        for(int i = 0; i < puzzle.Buckets(); ++i) {
+            if(puzzle.Amount(c, i) != puzzle.Amount(code, i)) {
+                ++diff;
+            }
+        }
+        return (diff + 1) / 2;
+    }
+};
+
+namespace detail {
+
+// 双向搜索一侧的状态：BFS树、每个节点的深度，以及状态编码到节点下标的平坦索引
+struct SearchSide {
+    static constexpr uint32_t kNone = SearchTree::kNoParent;
+
+    SearchTree tree;
+    std::vector<uint32_t> depth;
+    std::vector<uint32_t> index; // 按状态编码索引，kNone表示还没访问过
+    uint32_t level_begin = 0;    // 当前层在tree里的起始下标
+
+    SearchSide(uint64_t state_count, uint64_t root): index(state_count, kNone) {
+        index[root] = tree.Add(root, SearchTree::kNoParent, 0);
+        depth.push_back(0);
+    }
+
+    uint32_t FrontierSize() const { return tree.Size() - level_begin; }
+
+    void Add(uint64_t code, uint32_t parent, uint16_t move) {
+        index[code] = tree.Add(code, parent, move);
+        depth.push_back(depth[parent] + 1);
+    }
+};
+
+} // namespace detail
+
+// 双向BFS。每次展开两侧中较小的那一层；一层展开完之后如果两侧有交点，
+// 取两侧深度之和最小的交点拼出路径，这样得到的也是最短解。
+inline Solution BidirectionalSolve(const JugPuzzle& puzzle, uint64_t start, uint64_t target) {
+    using detail::SearchSide;
+    Solution result;
+    if(start == target) {
+        result.found = true;
+        return result;
+    }
+
+    const int n = puzzle.Buckets();
+    SearchSide forward(puzzle.StateCount(), start);
+    SearchSide backward(puzzle.StateCount(), target);
+    uint32_t best = SearchSide::kNone; // 最短的交点长度
+    uint64_t meet = 0;
+
+    auto visit = [&](SearchSide& self, const SearchSide& other, uint64_t code,
+                     uint32_t parent, uint16_t move) {
+        if(self.index[code] != SearchSide::kNone) {
+            return;
+        }
+        self.Add(code, parent, move);
+        uint32_t o = other.index[code];
+        if(o != SearchSide::kNone) {
+            uint32_t len = self.depth.back() + other.depth[o];
+            if(len < best) {
+                best = len;
+                meet = code;
+            }
+        }
+    };
+
+    while(best == SearchSide::kNone && forward.FrontierSize() > 0 && backward.FrontierSize() > 0) {
+        bool go_forward = forward.FrontierSize() <= backward.FrontierSize();
+        SearchSide& self = go_forward ? forward : backward;
+        const SearchSide& other = go_forward ? backward : forward;
+        uint32_t level_end = self.tree.Size();
+        for(uint32_t k = self.level_begin; k < level_end; ++k) {
+            uint64_t code = self.tree.codes[k];
+            ++result.expanded;
+            for(int i = 0; i < n; ++i) {
+                for(int j = 0; j < n; ++j) {
+                    uint16_t move = uint16_t(i * n + j);
+                    if(go_forward) {
+                        if(puzzle.CanPour(code, i, j)) {
+                            visit(self, other, puzzle.Pour(code, i, j), k, move);
+                        }
+                    } else {
+                        puzzle.Unpour(code, i, j, [&](uint64_t prev) {
+                            visit(self, other, prev, k, move);
+                        });
+                    }
+                }
+            }
+        }
+        self.level_begin = level_end;
+    }
+    if(best == SearchSide::kNone) {
+        return result;
+    }
+
+    // 正向树里是从起点到交点的倒法；反向树里从交点沿父指针走回终点，每条边正好是一次正向倒水
+    result.found = true;
+    result.moves = forward.tree.PathTo(forward.index[meet], n);
+    std::vector<Move> tail = backward.tree.PathTo(backward.index[meet], n);
+    result.moves.insert(result.moves.end(), tail.rbegin(), tail.rend());
+    return result;
+}
+
+// A*搜索。启发函数一致时，每个状态第一次出堆时的步数就是最短的，所以出堆后不再重复扩展。
+template <typename Pred, typename Heuristic>
+Solution AStarSolve(const JugPuzzle& puzzle, uint64_t start, Pred is_target, Heuristic h) {
+    struct Entry {
+        uint32_t f;
+        uint32_t g;
+        uint32_t node;
+
+        // f小的优先，f相同时g大的（离目标更近的）优先
+        bool operator<(const Entry& o) const {
+            return f != o.f ? f > o.f : g < o.g;
+        }
+    };
+    static constexpr uint32_t kInf = SearchTree::kNoParent;
+
+    Solution result;
+    const int n = puzzle.Buckets();
+    SearchTree tree;
+    std::vector<uint32_t> best_g(puzzle.StateCount(), kInf);
+    Bitmap closed(puzzle.StateCount());
+    std::priority_queue<Entry> open;
+
+    best_g[start] = 0;
+    open.push(Entry{uint32_t(h(puzzle, start)), 0, tree.Add(start, SearchTree::kNoParent, 0)});
+    while(!open.empty()) {
+        Entry e = open.top();
+        open.pop();
+        uint64_t code = tree.codes[e.node];
+        if(closed.TestAndSet(code)) {
+            continue; // 堆里过期的重复项
+        }
+        if(is_target(puzzle, code)) {
+            result.found = true;
+            result.moves = tree.PathTo(e.node, n);
+            return result;
+        }
+        ++result.expanded;
+        for(int i = 0; i < n; ++i) {
+            for(int j = 0; j < n; ++j) {
+                if(!puzzle.CanPour(code, i, j)) {
+                    continue;
+                }
+                uint64_t next = puzzle.Pour(code, i, j);
+                uint32_t g = e.g + 1;
+                if(closed.Test(next) || g >= best_g[next]) {
+                    continue;
+                }
+                best_g[next] = g;
+                uint32_t node = tree.Add(next, e.node, uint16_t(i * n + j));
+                open.push(Entry{g + uint32_t(h(puzzle, next)), g, node});
+            }
+        }
+    }
+    return result;
+}
+
+#endif // HEURISTIC_SEARCH_H
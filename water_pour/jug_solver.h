@@ -0,0 +1,227 @@
+#ifndef JUG_SOLVER_H
+#define JUG_SOLVER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// N个桶的倒水问题通用求解器。
+// 状态编码成一个混合进制整数：第i个桶的水量是第i位，进制是V[i]+1。
+// 这样所有状态都落在[0, StateCount())里，visited只需要一个平坦的位图，
+// 每个状态1个bit，几千万个状态也只要几MB，不需要像std::set那样每个状态分配一个节点。
+// 求解器全部是constexpr的（需要C++20的constexpr std::vector），常量谜题可以在编译期解完，见static_solver.h。
+
+struct Move {
+    int from; // 从哪个桶倒
+    int to;   // 倒到哪个桶
+};
+
+class Bitmap {
+public:
+    constexpr explicit Bitmap(uint64_t n): bits_((n + 63) / 64, 0) {}
+
+    constexpr bool Test(uint64_t i) const {
+        return (bits_[i >> 6] >> (i & 63)) & 1;
+    }
+
+    // 置位，返回置位之前是否已经是1
+    constexpr bool TestAndSet(uint64_t i) {
+        uint64_t mask = uint64_t(1) << (i & 63);
+        uint64_t& word = bits_[i >> 6];
+        bool old = word & mask;
+        word |= mask;
+        return old;
+    }
+private:
+    std::vector<uint64_t> bits_;
+};
+
+class JugPuzzle {
+public:
+    constexpr explicit JugPuzzle(std::vector<int> capacities): V_(std::move(capacities)) {
+        if(V_.empty() || V_.size() > 255) {
+            throw std::invalid_argument("bucket count must be in [1, 255]");
+        }
+        stride_.resize(V_.size());
+        uint64_t n = 1;
+        for(size_t i = 0; i < V_.size(); ++i) {
+            if(V_[i] <= 0) {
+                throw std::invalid_argument("bucket capacity must be positive");
+            }
+            uint64_t radix = uint64_t(V_[i]) + 1;
+            if(n > std::numeric_limits<uint64_t>::max() / radix) {
+                throw std::invalid_argument("state space does not fit in 64 bits");
+            }
+            stride_[i] = n;
+            n *= radix;
+        }
+        state_count_ = n;
+    }
+
+    constexpr int Buckets() const { return int(V_.size()); }
+    constexpr int Capacity(int i) const { return V_[i]; }
+    constexpr uint64_t StateCount() const { return state_count_; }
+
+    constexpr uint64_t Encode(const std::vector<int>& w) const {
+        if(w.size() != V_.size()) {
+            throw std::invalid_argument("bucket count mismatch");
+        }
+        uint64_t code = 0;
+        for(size_t i = 0; i < w.size(); ++i) {
+            if(w[i] < 0 || w[i] > V_[i]) {
+                throw std::invalid_argument("water amount out of range");
+            }
+            code += uint64_t(w[i]) * stride_[i];
+        }
+        return code;
+    }
+
+    constexpr std::vector<int> Decode(uint64_t code) const {
+        std::vector<int> w(V_.size());
+        for(size_t i = 0; i < V_.size(); ++i) {
+            w[i] = int(code % (uint64_t(V_[i]) + 1));
+            code /= uint64_t(V_[i]) + 1;
+        }
+        return w;
+    }
+
+    constexpr int Amount(uint64_t code, int i) const {
+        return int(code / stride_[i] % (uint64_t(V_[i]) + 1));
+    }
+
+    constexpr bool CanPour(uint64_t code, int i, int j) const {
+        // 从i往j倒，条件是i有水（不为空）且j未满。
+        return i != j && Amount(code, i) > 0 && Amount(code, j) < V_[j];
+    }
+
+    // 倒水只是把d升水从第i位挪到第j位，直接在编码上加减，不用解码整个状态。
+    constexpr uint64_t Pour(uint64_t code, int i, int j) const {
+        int wi = Amount(code, i);
+        int room = V_[j] - Amount(code, j);
+        uint64_t d = uint64_t(wi < room ? wi : room); // 要么把i倒空，要么把j倒满
+        return code - d * stride_[i] + d * stride_[j];
+    }
+    // 反向倒水：枚举所有经过一次i->j倒水后恰好变成code的状态。
+    // 倒完之后要么i空了，要么j满了，否则code不可能是i->j倒出来的；
+    // 倒过去的水量d可以是1到min(j里的水, i剩下的空间)之间的任何值。
+    template <typename F>
+    constexpr void Unpour(uint64_t code, int i, int j, F&& f) const {
+        int wi = Amount(code, i);
+        int wj = Amount(code, j);
+        if(i == j || (wi != 0 && wj != V_[j])) {
+            return;
+        }
+        int max_d = wj < V_[i] - wi ? wj : V_[i] - wi;
+        for(int d = 1; d <= max_d; ++d) {
+            f(code + uint64_t(d) * stride_[i] - uint64_t(d) * stride_[j]);
+        }
+    }
+private:
+    std::vector<int> V_;
+    std::vector<uint64_t> stride_;
+    uint64_t state_count_ = 0;
+};
+
+// BFS树。节点按发现顺序存放，每个节点只记父节点下标和倒水动作编号，
+// 路径只在找到解之后沿父指针回溯一次，搜索过程中不再为每个状态复制步骤列表。
+struct SearchTree {
+    static constexpr uint32_t kNoParent = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint64_t> codes;
+    std::vector<uint32_t> parent;
+    std::vector<uint16_t> move; // 编号为from * Buckets() + to
+
+    constexpr uint32_t Size() const { return uint32_t(codes.size()); }
+
+    constexpr uint32_t Add(uint64_t code, uint32_t p, uint16_t m) {
+        if(codes.size() >= kNoParent) {
+            throw std::length_error("too many states for 32-bit node index");
+        }
+        codes.push_back(code);
+        parent.push_back(p);
+        move.push_back(m);
+        return uint32_t(codes.size() - 1);
+    }
+
+    constexpr std::vector<Move> PathTo(uint32_t node, int buckets) const {
+        std::vector<Move> moves;
+        for(; parent[node] != kNoParent; node = parent[node]) {
+            moves.push_back(Move{move[node] / buckets, move[node] % buckets});
+        }
+        std::reverse(moves.begin(), moves.end());
+        return moves;
+    }
+};
+
+// 常用的目标：某个桶里恰好有amount升水
+struct AnyBucketContains {
+    int amount;
+
+    constexpr bool operator()(const JugPuzzle& puzzle, uint64_t code) const {
+        for(int i = 0; i < puzzle.Buckets(); ++i) {
+            if(puzzle.Amount(code, i) == amount) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// 目标完全确定：所有桶的水量都等于某个状态
+struct ExactState {
+    uint64_t code;
+
+    constexpr bool operator()(const JugPuzzle&, uint64_t c) const {
+        return c == code;
+    }
+};
+
+struct Solution {
+    bool found = false;
+    std::vector<Move> moves;
+    uint64_t expanded = 0; // 出队扩展过的状态数
+};
+
+// 广度优先搜索，返回从start到第一个满足is_target(puzzle, code)的状态的最短倒水步骤。
+template <typename Pred>
+constexpr Solution Solve(const JugPuzzle& puzzle, uint64_t start, Pred is_target) {
+    Solution result;
+    if(is_target(puzzle, start)) {
+        result.found = true;
+        return result;
+    }
+
+    const int n = puzzle.Buckets();
+    Bitmap visited(puzzle.StateCount());
+    SearchTree tree;
+    tree.Add(start, SearchTree::kNoParent, 0);
+    visited.TestAndSet(start);
+    // tree本身就是队列，head之前的节点都已经扩展过
+    for(uint32_t head = 0; head < tree.Size(); ++head) {
+        uint64_t code = tree.codes[head];
+        ++result.expanded;
+        for(int i = 0; i < n; ++i) {
+            for(int j = 0; j < n; ++j) {
+                if(!puzzle.CanPour(code, i, j)) {
+                    continue;
+                }
+                uint64_t next = puzzle.Pour(code, i, j);
+                if(visited.TestAndSet(next)) {
+                    continue;
+                }
+                uint32_t node = tree.Add(next, head, uint16_t(i * n + j));
+                if(is_target(puzzle, next)) {
+                    result.found = true;
+                    result.moves = tree.PathTo(node, n);
+                    return result;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+#endif // JUG_SOLVER_H
@@ -0,0 +1,163 @@
+#ifndef PARALLEL_BFS_H
+#define PARALLEL_BFS_H
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "jug_solver.h"
+
+// 多线程按层同步的BFS。
+// 每一层的frontier被所有线程按块领取并展开，visited是原子位图，fetch_or抢到某个状态的线程负责它；
+// 新状态先写到各线程自己的缓冲区，层与层之间按前缀和把缓冲区并行拷贝成下一层。
+// 按层搜索保证找到的解和单线程BFS一样短；多线程时同一层里谁先抢到某个状态不确定，
+// 所以具体走法可能和单线程的不同，threads为1时和Solve()的结果完全一样。
+
+class AtomicBitmap {
+public:
+    explicit AtomicBitmap(uint64_t n): bits_((n + 63) / 64) {}
+
+    bool Test(uint64_t i) const {
+        return (bits_[i >> 6].load(std::memory_order_relaxed) >> (i & 63)) & 1;
+    }
+
+    // 原子地置位，返回置位之前是否已经是1；返回false说明是当前线程抢到了这个状态
+    bool TestAndSet(uint64_t i) {
+        uint64_t mask = uint64_t(1) << (i & 63);
+        return bits_[i >> 6].fetch_or(mask, std::memory_order_relaxed) & mask;
+    }
+private:
+    std::vector<std::atomic<uint64_t>> bits_;
+};
+
+template <typename Pred>
+Solution ParallelSolve(const JugPuzzle& puzzle, uint64_t start, Pred is_target,
+                       unsigned threads = std::thread::hardware_concurrency()) {
+    struct Node {
+        uint64_t code;
+        uint32_t parent; // 在上一层里的下标
+        uint16_t move;
+    };
+    // 每个线程私有的输出缓冲区，按缓存行对齐避免伪共享
+    struct alignas(64) Buffer {
+        std::vector<Node> nodes;
+        size_t found; // 第一个目标状态在nodes里的下标
+        uint64_t expanded = 0;
+    };
+    static constexpr size_t kChunk = 1024;
+    static constexpr size_t kNotFound = size_t(-1);
+
+    Solution result;
+    if(is_target(puzzle, start)) {
+        result.found = true;
+        return result;
+    }
+    if(threads == 0) {
+        threads = 1;
+    }
+
+    const int n = puzzle.Buckets();
+    AtomicBitmap visited(puzzle.StateCount());
+    visited.TestAndSet(start);
+
+    std::vector<std::vector<Node>> levels;
+    levels.push_back({Node{start, 0, 0}});
+    std::vector<Node> next;
+    std::vector<Buffer> local(threads);
+    std::vector<size_t> offset(threads);
+    std::atomic<size_t> cursor{0};
+    size_t target = kNotFound; // 目标状态在最后一层里的下标
+    bool done = false;
+
+    // 展开结束后由最后到达屏障的线程执行：算出每个线程在下一层的起始位置，判断是否结束
+    auto plan_merge = [&]() noexcept {
+        size_t total = 0;
+        for(unsigned t = 0; t < threads; ++t) {
+            offset[t] = total;
+            if(target == kNotFound && local[t].found != kNotFound) {
+                target = total + local[t].found;
+            }
+            total += local[t].nodes.size();
+        }
+        next.resize(total);
+    };
+    // 合并结束后执行：下一层成为新的frontier
+    auto finish_level = [&]() noexcept {
+        done = target != kNotFound || next.empty();
+        levels.push_back(std::move(next));
+        next = {};
+        cursor.store(0, std::memory_order_relaxed);
+    };
+    std::barrier expand_done(threads, plan_merge);
+    std::barrier merge_done(threads, finish_level);
+
+    auto worker = [&](unsigned t) {
+        Buffer& buf = local[t];
+        std::vector<Node>& out = buf.nodes;
+        buf.found = kNotFound;
+        while(!done) {
+            const std::vector<Node>& frontier = levels.back();
+            for(;;) {
+                size_t begin = cursor.fetch_add(kChunk, std::memory_order_relaxed);
+                if(begin >= frontier.size()) {
+                    break;
+                }
+                size_t end = std::min(begin + kChunk, frontier.size());
+                for(size_t k = begin; k < end; ++k) {
+                    uint64_t code = frontier[k].code;
+                    ++buf.expanded;
+                    for(int i = 0; i < n; ++i) {
+                        for(int j = 0; j < n; ++j) {
+                            if(!puzzle.CanPour(code, i, j)) {
+                                continue;
+                            }
+                            uint64_t s = puzzle.Pour(code, i, j);
+                            if(visited.TestAndSet(s)) {
+                                continue;
+                            }
+                            if(buf.found == kNotFound && is_target(puzzle, s)) {
+                                buf.found = out.size();
+                            }
+                            out.push_back(Node{s, uint32_t(k), uint16_t(i * n + j)});
+                        }
+                    }
+                }
+            }
+            expand_done.arrive_and_wait();
+
+            std::copy(out.begin(), out.end(), next.begin() + offset[t]);
+            out.clear();
+            buf.found = kNotFound;
+            merge_done.arrive_and_wait();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for(auto& th: pool) {
+        th.join();
+    }
+
+    for(const Buffer& buf: local) {
+        result.expanded += buf.expanded;
+    }
+    if(target == kNotFound) {
+        return result;
+    }
+    result.found = true;
+    size_t index = target;
+    for(size_t l = levels.size() - 1; l > 0; --l) {
+        const Node& node = levels[l][index];
+        result.moves.push_back(Move{node.move / n, node.move % n});
+        index = node.parent;
+    }
+    std::reverse(result.moves.begin(), result.moves.end());
+    return result;
+}
+
+#endif // PARALLEL_BFS_H
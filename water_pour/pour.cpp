@@ -1,73 +1,190 @@
-#include <queue>
-#include <array>
-#include <set>
 #include <iostream>
-#include <cassert>
 #include <vector>
 #include <string>
+#include <cstdlib>
+#include <cstring>
 #include <format> // 用c++23编译，gcc14可以编过
+#include "jug_solver.h"
+#include "parallel_bfs.h"
+#include "heuristic_search.h"
+#include "reach_table.h"
+#include "static_solver.h"
 
 using namespace std;
 
-const array<char, 3> names = {'A', 'B', 'C'};
-const array<int, 3> V = {8, 5, 3};
+// 经典的8、5、3三个桶量出4升水，在编译期就解好了
+constexpr PuzzleSpec<3> kClassic{{8, 5, 3}, {8, 0, 0}, 4};
+static_assert(kSolvedPuzzle<kClassic>.found && kSolvedPuzzle<kClassic>.steps.size() == 6);
 
-struct State {
-    array<int, 3> w; // 记录每个桶的水
-    vector<string> steps; // 记录倒水的步骤
+// 把一个状态格式化成"8, 0, 0"
+string FormatState(const vector<int>& w) {
+    string str;
+    for(size_t i = 0; i < w.size(); ++i) {
+        if(i > 0) {
+            str += ", ";
+        }
+        str += std::format("{}", w[i]);
+    }
+    return str;
+}
+
+// 解析"4,4,0"这样的状态
+vector<int> ParseState(const char* s) {
+    vector<int> w;
+    for(char* end; *s; s = *end ? end + 1 : end) {
+        w.push_back(int(strtol(s, &end, 10)));
+    }
+    return w;
+}
 
-    bool CanPour(int i, int j) const {
-        // 从左边往右边倒，条件是左边有水（不为空）且右边未满。
-        return w[i] > 0 && (w[j] < V[j]);
+void PrintSteps(const JugPuzzle& puzzle, uint64_t start, const vector<Move>& moves) {
+    uint64_t code = start;
+    for(const Move& m: moves) {
+        code = puzzle.Pour(code, m.from, m.to);
+        std::cout<<std::format("{}->{}: {}", char('A' + m.from), char('A' + m.to),
+            FormatState(puzzle.Decode(code)))<<"\n";
     }
+}
 
-    State Pour(int i, int j) const {
-        assert(CanPour(i, j));
-        State s2 = *this;
-        // 要么把第i个桶倒空
-        if(s2.w[i] <= V[j] - s2.w[j]) {
-            s2.w[j] += s2.w[i];
-            s2.w[i] = 0;
-        } else { // 要么把第j个桶倒满
-            s2.w[i] -= (V[j] - s2.w[j]);
-            s2.w[j] = V[j];
+// 查表模式：表文件存在且桶的容量一致就直接加载，否则建表并存盘，然后依次回答每个水量的查询
+int RunTable(const JugPuzzle& puzzle, uint64_t start, const string& path, const vector<int>& queries) {
+    ReachTable table;
+    bool loaded = !path.empty() && ReachTable::Load(path, table);
+    vector<int> V;
+    for(int i = 0; i < puzzle.Buckets(); ++i) {
+        V.push_back(puzzle.Capacity(i));
+    }
+    if(!loaded || table.Capacities() != V || table.Start() != start) {
+        table = ReachTable::Build(puzzle, start);
+        if(!path.empty() && !table.Save(path)) {
+            std::cerr<<"unable to save table to "<<path<<"\n";
         }
-        auto str = std::format("{}->{}: {}, {}, {}", names[i], names[j], s2.w[0], s2.w[1], s2.w[2]);
-        s2.steps.push_back(str);
-        return s2;
+        loaded = false;
     }
-};
+    std::cout<<std::format("{} states {}\n", table.Size(), loaded ? "loaded" : "built");
 
-std::set<array<int, 3>> visited;
+    int failed = 0;
+    for(int k: queries) {
+        vector<Move> moves;
+        if(!table.Query(k, moves)) {
+            std::cout<<std::format("{}: not found\n", k);
+            ++failed;
+            continue;
+        }
+        std::cout<<std::format("{}: {} steps\n", k, moves.size());
+        PrintSteps(puzzle, start, moves);
+    }
+    return failed == 0 ? 0 : 1;
+}
 
-int main() {
-    queue<State> q;
-    q.push(State{{8, 0, 0}, {}});
-    visited.insert(array<int, 3>{8, 0, 0});
-    while(!q.empty()) {
-        auto state = q.front();
-        q.pop();
-        for(int i = 0; i < 3; ++i) {
-            for(int j = 0; j < 3; ++j) {
-                if(i == j) {
-                    continue;
-                }
+// 用法：pour [-j 线程数] [-m bfs|bidir|astar|all|table] [-t 目标状态] [-f 表文件] [-q 水量列表]
+//            [目标水量 桶1容量 桶2容量 ...]
+// 不带参数时就是经典的8、5、3三个桶量出4升水，直接输出编译期求出的解；
+// 其他谜题在运行时求解，起始状态是第一个桶装满。
+// -j大于1时BFS用多线程按层搜索。
+// -t 4,4,0 指定完整的目标状态，代替"某个桶里有目标水量"，双向搜索必须指定。
+// -m all 依次运行所有搜索方式，并打印各自扩展过的状态数。
+// -m table 建一张从起点出发的完整最短路径表（-f 指定存盘文件，下次直接加载），
+//   然后回答 -q 1,2,4 里每个水量怎么量，没有-q时回答目标水量。
+int main(int argc, char* argv[]) {
+    int target = kClassic.target;
+    vector<int> V(kClassic.capacities.begin(), kClassic.capacities.end());
+    unsigned threads = 1;
+    string mode = "bfs";
+    vector<int> target_state;
+    string table_path;
+    vector<int> queries;
+    vector<const char*> args;
+    for(int i = 1; i < argc; ++i) {
+        if(i + 1 < argc && strcmp(argv[i], "-j") == 0) {
+            threads = unsigned(atoi(argv[++i]));
+        } else if(i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+            mode = argv[++i];
+        } else if(i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+            target_state = ParseState(argv[++i]);
+        } else if(i + 1 < argc && strcmp(argv[i], "-f") == 0) {
+            table_path = argv[++i];
+        } else if(i + 1 < argc && strcmp(argv[i], "-q") == 0) {
+            queries = ParseState(argv[++i]);
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if(args.size() >= 2) {
+        target = atoi(args[0]);
+        V.clear();
+        for(size_t i = 1; i < args.size(); ++i) {
+            V.push_back(atoi(args[i]));
+        }
+    }
 
-                if(state.CanPour(i, j)) {
-                    State s2 = state.Pour(i, j);
-                    if(s2.w[0] == 4 || s2.w[1] == 4) {
-                        std::cout<<"found: \n";
-                        for(const auto& str: s2.steps) {
-                            std::cout<<str<<"\n";
-                        }
-                        return 0;
-                    }
-                    if(! visited.contains(s2.w)) {
-                        q.push(s2);
-                        visited.insert(s2.w);
-                    }
-                }
+    if(args.empty() && mode == "bfs" && target_state.empty()) {
+        std::cout<<"found: \n";
+        for(const auto& step: kSolvedPuzzle<kClassic>.steps) {
+            std::cout<<char('A' + step.from)<<"->"<<char('A' + step.to)<<": "
+                <<step.w[0]<<", "<<step.w[1]<<", "<<step.w[2]<<"\n";
+        }
+        return 0;
+    }
+
+    JugPuzzle puzzle(V);
+    vector<int> w(V.size(), 0);
+    w[0] = V[0];
+    uint64_t start = puzzle.Encode(w);
+    if(mode == "table") {
+        if(queries.empty()) {
+            queries.push_back(target);
+        }
+        return RunTable(puzzle, start, table_path, queries);
+    }
+
+    bool exact = !target_state.empty();
+    uint64_t goal = exact ? puzzle.Encode(target_state) : 0;
+
+    // 目标是完整状态还是"某个桶里有target升"，两种谓词和启发函数的类型不同
+    auto run = [&](const string& m, auto is_target, auto h) -> Solution {
+        if(m == "bidir") {
+            if(!exact) {
+                std::cerr<<"bidirectional search needs -t\n";
+                exit(2);
+            }
+            return BidirectionalSolve(puzzle, start, goal);
+        }
+        if(m == "astar") {
+            return AStarSolve(puzzle, start, is_target, h);
+        }
+        return threads > 1
+            ? ParallelSolve(puzzle, start, is_target, threads)
+            : Solve(puzzle, start, is_target);
+    };
+    auto solve = [&](const string& m) {
+        return exact ? run(m, ExactState{goal}, ExactStateHeuristic{goal})
+                     : run(m, AnyBucketContains{target}, ContainsHeuristic{target});
+    };
+
+    Solution s;
+    if(mode == "all") {
+        vector<string> modes = {"bfs", "astar"};
+        if(exact) {
+            modes.insert(modes.begin() + 1, "bidir");
+        }
+        for(const string& m: modes) {
+            Solution r = solve(m);
+            std::cout<<std::format("{:6}{} steps, {} expanded\n", m,
+                r.found ? int(r.moves.size()) : -1, r.expanded);
+            if(m == "bfs") {
+                s = std::move(r);
             }
         }
+    } else {
+        s = solve(mode);
+    }
+
+    if(!s.found) {
+        std::cout<<"not found\n";
+        return 1;
     }
-}
\ No newline at end of file
+    std::cout<<"found: \n";
+    PrintSteps(puzzle, start, s.moves);
+    return 0;
+}
@@ -0,0 +1,187 @@
+#ifndef REACH_TABLE_H
+#define REACH_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "jug_solver.h"
+
+// 同一组桶反复问"能不能量出k升、怎么量"时，不必每次都重新搜索：
+// 从起点做一次完整的BFS，把最短路径树存成表，之后每次查询只沿父指针回溯，代价是O(路径长度)。
+// 树按BFS顺序存放，父节点总在子节点之前，所以存盘时只需要父节点下标和倒水动作（每个状态6字节），
+// 状态编码在加载时按顺序重放一遍就能恢复。
+class ReachTable {
+public:
+    ReachTable() = default;
+
+    static ReachTable Build(const JugPuzzle& puzzle, uint64_t start) {
+        const int n = puzzle.Buckets();
+        ReachTable table;
+        table.start_ = start;
+        for(int i = 0; i < n; ++i) {
+            table.V_.push_back(puzzle.Capacity(i));
+        }
+
+        Bitmap visited(puzzle.StateCount());
+        SearchTree& tree = table.tree_;
+        tree.Add(start, SearchTree::kNoParent, 0);
+        visited.TestAndSet(start);
+        for(uint32_t head = 0; head < tree.Size(); ++head) {
+            uint64_t code = tree.codes[head];
+            for(int i = 0; i < n; ++i) {
+                for(int j = 0; j < n; ++j) {
+                    if(!puzzle.CanPour(code, i, j)) {
+                        continue;
+                    }
+                    uint64_t next = puzzle.Pour(code, i, j);
+                    if(!visited.TestAndSet(next)) {
+                        tree.Add(next, head, uint16_t(i * n + j));
+                    }
+                }
+            }
+        }
+        table.BuildIndex(puzzle);
+        return table;
+    }
+
+    // 文件格式（本机字节序）：
+    // "JUGT" | 桶数u32 | 容量u32... | 起点u64 | 节点数u32 | 父节点u32... | 动作u16...
+    bool Save(const std::string& path) const {
+        std::ofstream file(path, std::ios::out | std::ios::binary);
+        if(!file) {
+            return false;
+        }
+        uint32_t buckets = uint32_t(V_.size());
+        uint32_t size = tree_.Size();
+        file.write(kMagic, sizeof(kMagic));
+        file.write((const char*)&buckets, sizeof(buckets));
+        for(int v: V_) {
+            uint32_t cap = uint32_t(v);
+            file.write((const char*)&cap, sizeof(cap));
+        }
+        file.write((const char*)&start_, sizeof(start_));
+        file.write((const char*)&size, sizeof(size));
+        file.write((const char*)tree_.parent.data(), size * sizeof(uint32_t));
+        file.write((const char*)tree_.move.data(), size * sizeof(uint16_t));
+        return bool(file);
+    }
+
+    // 读入并校验一张表，文件损坏或者和桶的容量对不上时返回false
+    static bool Load(const std::string& path, ReachTable& table) {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        char magic[sizeof(kMagic)];
+        uint32_t buckets = 0;
+        if(!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kMagic)
+            || !file.read((char*)&buckets, sizeof(buckets)) || buckets == 0 || buckets > 255) {
+            return false;
+        }
+        ReachTable t;
+        for(uint32_t i = 0; i < buckets; ++i) {
+            uint32_t cap = 0;
+            if(!file.read((char*)&cap, sizeof(cap)) || cap == 0 || cap > uint32_t(INT32_MAX)) {
+                return false;
+            }
+            t.V_.push_back(int(cap));
+        }
+        uint32_t size = 0;
+        if(!file.read((char*)&t.start_, sizeof(t.start_))
+            || !file.read((char*)&size, sizeof(size)) || size == 0) {
+            return false;
+        }
+        try {
+            t.Restore(JugPuzzle(t.V_), file, size);
+        } catch(const std::invalid_argument&) {
+            return false; // 容量组合超出64位编码范围
+        }
+        if(t.tree_.codes.size() != size) {
+            return false;
+        }
+        table = std::move(t);
+        return true;
+    }
+
+    const std::vector<int>& Capacities() const { return V_; }
+    uint64_t Start() const { return start_; }
+    uint32_t Size() const { return tree_.Size(); }
+
+    // 量出amount升水的最短倒法，量不出来返回false
+    bool Query(int amount, std::vector<Move>& moves) const {
+        if(amount < 0 || amount >= int(by_amount_.size())
+            || by_amount_[amount] == SearchTree::kNoParent) {
+            return false;
+        }
+        moves = tree_.PathTo(by_amount_[amount], int(V_.size()));
+        return true;
+    }
+
+    // 到达某个完整状态的最短倒法，状态从起点不可达时返回false
+    bool QueryState(uint64_t code, std::vector<Move>& moves) const {
+        auto it = std::lower_bound(by_code_.begin(), by_code_.end(), code,
+            [this](uint32_t node, uint64_t c) { return tree_.codes[node] < c; });
+        if(it == by_code_.end() || tree_.codes[*it] != code) {
+            return false;
+        }
+        moves = tree_.PathTo(*it, int(V_.size()));
+        return true;
+    }
+private:
+    static constexpr char kMagic[4] = {'J', 'U', 'G', 'T'};
+
+    // 读入父节点和动作，重放倒水动作恢复每个节点的状态编码；数据不合法时codes留空
+    void Restore(const JugPuzzle& puzzle, std::istream& in, uint32_t size) {
+        if(start_ >= puzzle.StateCount() || size > puzzle.StateCount()) {
+            return;
+        }
+        tree_.parent.resize(size);
+        tree_.move.resize(size);
+        if(!in.read((char*)tree_.parent.data(), size * sizeof(uint32_t))
+            || !in.read((char*)tree_.move.data(), size * sizeof(uint16_t))
+            || tree_.parent[0] != SearchTree::kNoParent) {
+            return;
+        }
+        const int n = puzzle.Buckets();
+        std::vector<uint64_t> codes(size);
+        codes[0] = start_;
+        for(uint32_t k = 1; k < size; ++k) {
+            uint32_t p = tree_.parent[k];
+            int from = tree_.move[k] / n;
+            int to = tree_.move[k] % n;
+            if(p >= k || from >= n || !puzzle.CanPour(codes[p], from, to)) {
+                return;
+            }
+            codes[k] = puzzle.Pour(codes[p], from, to);
+        }
+        tree_.codes = std::move(codes);
+        BuildIndex(puzzle);
+    }
+
+    // 节点按BFS顺序排列，每个水量第一次出现的节点就是最浅的
+    void BuildIndex(const JugPuzzle& puzzle) {
+        by_amount_.assign(*std::max_element(V_.begin(), V_.end()) + 1, SearchTree::kNoParent);
+        for(uint32_t k = 0; k < tree_.Size(); ++k) {
+            for(int i = 0; i < puzzle.Buckets(); ++i) {
+                uint32_t& slot = by_amount_[puzzle.Amount(tree_.codes[k], i)];
+                if(slot == SearchTree::kNoParent) {
+                    slot = k;
+                }
+            }
+        }
+        by_code_.resize(tree_.Size());
+        for(uint32_t k = 0; k < tree_.Size(); ++k) {
+            by_code_[k] = k;
+        }
+        std::sort(by_code_.begin(), by_code_.end(),
+            [this](uint32_t a, uint32_t b) { return tree_.codes[a] < tree_.codes[b]; });
+    }
+
+    std::vector<int> V_;
+    uint64_t start_ = 0;
+    SearchTree tree_;
+    std::vector<uint32_t> by_amount_; // 下标是水量，值是第一个出现该水量的节点
+    std::vector<uint32_t> by_code_;   // 按状态编码排好序的节点下标
+};
+
+#endif // REACH_TABLE_H
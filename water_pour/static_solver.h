@@ -0,0 +1,67 @@
+#ifndef STATIC_SOLVER_H
+#define STATIC_SOLVER_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "jug_solver.h"
+
+// 编译期求解。容量、起点和目标都是常量的谜题，直接用Solve()在常量求值里跑完BFS，
+// 结果拷进定长的std::array作为静态数据嵌进程序，运行时不再搜索也不再分配内存。
+// 例：
+//   constexpr PuzzleSpec<3> kClassic{{8, 5, 3}, {8, 0, 0}, 4};
+//   for(const auto& step: kSolvedPuzzle<kClassic>.steps) ...
+// 状态空间太大时可能会超过编译器的常量求值步数限制（gcc的-fconstexpr-ops-limit），这时请用运行时的Solve()。
+
+template <size_t N>
+struct PuzzleSpec {
+    std::array<int, N> capacities;
+    std::array<int, N> start;
+    int target; // 某个桶里有target升水
+};
+
+template <size_t N>
+struct StaticStep {
+    int from;
+    int to;
+    std::array<int, N> w; // 倒完之后每个桶的水
+};
+
+template <size_t N, size_t Steps>
+struct StaticSolution {
+    bool found;
+    std::array<StaticStep<N>, Steps> steps;
+};
+
+template <size_t N>
+constexpr Solution SolveSpec(const PuzzleSpec<N>& spec) {
+    JugPuzzle puzzle(std::vector<int>(spec.capacities.begin(), spec.capacities.end()));
+    uint64_t start = puzzle.Encode(std::vector<int>(spec.start.begin(), spec.start.end()));
+    return Solve(puzzle, start, AnyBucketContains{spec.target});
+}
+
+template <PuzzleSpec Spec>
+consteval auto SolveStatic() {
+    constexpr size_t N = Spec.capacities.size();
+    constexpr size_t kSteps = SolveSpec(Spec).moves.size(); // 先解一遍得到步数，作为数组长度
+
+    JugPuzzle puzzle(std::vector<int>(Spec.capacities.begin(), Spec.capacities.end()));
+    Solution s = SolveSpec(Spec);
+    StaticSolution<N, kSteps> out{};
+    out.found = s.found;
+    uint64_t code = puzzle.Encode(std::vector<int>(Spec.start.begin(), Spec.start.end()));
+    for(size_t k = 0; k < kSteps; ++k) {
+        code = puzzle.Pour(code, s.moves[k].from, s.moves[k].to);
+        out.steps[k].from = s.moves[k].from;
+        out.steps[k].to = s.moves[k].to;
+        for(size_t i = 0; i < N; ++i) {
+            out.steps[k].w[i] = puzzle.Amount(code, int(i));
+        }
+    }
+    return out;
+}
+
+template <PuzzleSpec Spec>
+inline constexpr auto kSolvedPuzzle = SolveStatic<Spec>();
+
+#endif // STATIC_SOLVER_H